@@ -1,16 +1,31 @@
 """Libraries for reading raw text files with Intel Hyperscan."""
 
 from hypergrep.utils import CALLBACK_TYPE
+from hypergrep.utils import Counters
 from hypergrep.utils import HS_FLAG_CASELESS
 from hypergrep.utils import HS_FLAG_DOTALL
 from hypergrep.utils import HS_FLAG_MULTILINE
 from hypergrep.utils import HS_FLAG_SINGLEMATCH
+from hypergrep.utils import HS_FLAG_SOM_LEFTMOST
+from hypergrep.utils import PATH_CALLBACK_TYPE
+from hypergrep.utils import RC_BINARY_FILE
 from hypergrep.utils import RC_INVALID_FILE
+from hypergrep.utils import RESULT_CONTEXT_AFTER
+from hypergrep.utils import RESULT_CONTEXT_BEFORE
+from hypergrep.utils import RESULT_MATCH
 from hypergrep.utils import Result
+from hypergrep.utils import SHARED_CALLBACK_TYPE
+from hypergrep.utils import Scanner
+from hypergrep.utils import SharedResult
+from hypergrep.utils import Stats
 from hypergrep.utils import check_compatibility
 from hypergrep.utils import configure_libraries
+from hypergrep.utils import count
 from hypergrep.utils import grep
+from hypergrep.utils import hyperscan_version
 from hypergrep.utils import prepare_patterns
 from hypergrep.utils import scan
+from hypergrep.utils import scan_files
+from hypergrep.utils import scan_range
 
 __version__ = "3.2.0"
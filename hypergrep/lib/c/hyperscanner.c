@@ -10,17 +10,34 @@
  *     ./hyperscanner <pattern> <input file>
  */
 
+// Required for memrchr() and other GNU extensions under strict C99 builds.
+#define _GNU_SOURCE
+
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
 
 #include <hs.h>
+// Direct streaming decode API used for zstd files, bypassing the gz* emulation layer.
+#include <zstd.h>
 // Use zstd_zlibwrapper.h instead of zlib.h, it has equivalents for all required gz* calls compatible with both types.
 // If a non-ZSTD compatible build is required, replace with zlib.h and no additional changes are needed.
 #include <zstd_zlibwrapper.h>
 
+// PATH_MAX is POSIX and not guaranteed by limits.h under strict C99, provide the common Linux default.
+#ifndef PATH_MAX
+#define PATH_MAX 4096
+#endif
+
 // Return codes for failures from hyperscanner.
 typedef enum hyperscanner_ret {
     HYPERSCANNER_COMPILE_MEM = 1,
@@ -29,22 +46,148 @@ typedef enum hyperscanner_ret {
     HYPERSCANNER_DB = 4,
     HYPERSCANNER_STATE_MEM = 5,
     HYPERSCANNER_GZ_OPEN = 6,
-    HYPERSCANNER_SCAN = 7
+    HYPERSCANNER_SCAN = 7,
+    HYPERSCANNER_HANDLE_MEM = 8,
+    HYPERSCANNER_MMAP = 9,
+    HYPERSCANNER_DECODE = 10,
+    HYPERSCANNER_BINARY = 11
 } hyperscanner_ret_t;
 
+// File types detectable from leading magic bytes, used to route scans to the fastest path.
+typedef enum hyperscanner_file_type {
+    HYPERSCANNER_FILE_PLAIN = 0,
+    HYPERSCANNER_FILE_GZIP = 1,
+    HYPERSCANNER_FILE_ZSTD = 2
+} hyperscanner_file_type_t;
+
+// How many bytes to feed to a single hs_scan() call on the memory mapped block path.
+// Large enough to amortize scan startup costs, small enough to keep match offsets hot in cache.
+#define HYPERSCANNER_BLOCK_SIZE (4 * 1024 * 1024)
+
+// How many leading decoded bytes to probe for NUL bytes when binary skipping is enabled.
+#define HYPERSCANNER_BINARY_PROBE 32768
+
+// Initial size class for the shared line arena. Typical log lines are a few hundred bytes, so scans
+// start small and the arena grows geometrically on demand instead of committing full read buffers.
+#define HYPERSCANNER_ARENA_MIN_SIZE 4096
+
+// How many upcoming files to hint to the kernel with posix_fadvise() on the tree scan path, so small
+// file reads overlap with scanning instead of serializing on open/read latency.
+#define HYPERSCANNER_TREE_READAHEAD 8
+
+// How many block buffers the scan pipeline keeps in flight between the reader thread and the
+// scanner. Deep enough to absorb storage latency spikes on cold cache and network attached volumes,
+// shallow enough that an idle pipeline only holds a few blocks of memory.
+#define HYPERSCANNER_PIPELINE_DEPTH 4
+
+// How many cloned scratch spaces a handle retains between scans by default. Parallel workers check
+// scratches out of the pool instead of paying hs_clone_scratch() per scan, a multi-megabyte
+// allocation for large databases that shows up as a fixed startup tax in per file latency.
+#define HYPERSCANNER_SCRATCH_POOL_SIZE 8
+
+// Result classifications so callers can distinguish context lines from the matches that caused them.
+#define HYPERSCANNER_RESULT_MATCH 0
+#define HYPERSCANNER_RESULT_CONTEXT_BEFORE 1
+#define HYPERSCANNER_RESULT_CONTEXT_AFTER 2
+
 /*
  * Stateful information used to buffer line matches from Intel Hyperscan during callbacks.
  *
  * id: The index of the pattern that matched the line.
  * line_number: The index of the line matched.
- * line: Contents of the line that was matched.
+ * line: Contents of the line that was matched. NUL terminated slice into the shared line arena,
+ *     only valid for the duration of the callback that delivers the result.
+ * length: Length of the line in bytes, excluding the NUL terminator.
+ * match_start: Offset within the line where the match began. Only populated when the pattern was
+ *     compiled with HS_FLAG_SOM_LEFTMOST, Hyperscan reports 0 otherwise.
+ * match_end: Offset within the line one past the final byte of the match.
+ * file_index: Position of the file that produced the match within the scanned file list.
+ *     Always 0 for single file scans.
+ * context: Classification of the result: HYPERSCANNER_RESULT_MATCH for matched lines, or the
+ *     before/after kinds when the line is reported only as context around a nearby match.
+ * id_mask: Bitmask of the pattern ids below 64 that matched the line. For normal scans this is the
+ *     single bit for id; with line dedup enabled every pattern that hit the line folds its bit in.
+ *     Ids of 64 and above report through id only and set no bit.
+ * byte_offset: Absolute byte offset where the line begins, i.e. grep -b. Offsets are within the
+ *     decoded stream for compressed files and within the file itself for plain files, so callers
+ *     can seek straight back to a reported record without rescanning.
  */
 typedef struct hyperscanner_result {
     unsigned int id;
     unsigned long long line_number;
     char* line;
+    unsigned int length;
+    unsigned long long match_start;
+    unsigned long long match_end;
+    unsigned int file_index;
+    unsigned int context;
+    unsigned long long id_mask;
+    unsigned long long byte_offset;
 } hyperscanner_result_t;
 
+// Distribution counter shapes. Line length buckets are powers of two, so bucket N covers lines of
+// 2^N to 2^(N+1) - 1 bytes and the last bucket absorbs everything longer. Batch fill buckets split
+// the result buffer capacity into even fractions, and per id tallies match the 64 bit id_mask width.
+#define HYPERSCANNER_COUNTER_LENGTH_BUCKETS 16
+#define HYPERSCANNER_COUNTER_FILL_BUCKETS 8
+#define HYPERSCANNER_COUNTER_IDS 64
+
+/*
+ * Opt-in distribution counters collected across a single file scan, beyond the per scan totals.
+ *
+ * Totals answer how long a scan took, distributions answer how to size it: line length spread picks
+ * buffer_size, batch fill levels pick buffer_count, and per id tallies expose which patterns carry
+ * the load. Updates are plain increments behind a single pointer check, so scans that do not enable
+ * them pay one predictable branch and enabled scans avoid full production trial and error runs.
+ *
+ * line_lengths: Histogram of scanned line lengths, including the trailing newline, in power of two
+ *     buckets. Bucket index is the position of the highest set bit of the length.
+ * matches_per_id: Matches recorded per pattern id, before any single match per line dedup.
+ *     Ids beyond the array are not tallied.
+ * batch_fill: Histogram of how full the result buffer was at each flush, in even fractions of its
+ *     capacity. A top heavy histogram means buffer_count is the batching bottleneck.
+ * buffer_refills: How many block reads the pipeline reader performed. 0 on the memory mapped path.
+ */
+typedef struct hyperscanner_counters {
+    unsigned long long line_lengths[HYPERSCANNER_COUNTER_LENGTH_BUCKETS];
+    unsigned long long matches_per_id[HYPERSCANNER_COUNTER_IDS];
+    unsigned long long batch_fill[HYPERSCANNER_COUNTER_FILL_BUCKETS];
+    unsigned long long buffer_refills;
+} hyperscanner_counters_t;
+
+/*
+ * Performance counters collected across a single file scan for capacity planning and tuning.
+ *
+ * bytes_read: Raw bytes read from storage, i.e. compressed size for gzip/zstd and file size for plain.
+ * bytes_scanned: Decoded bytes handed to hs_scan().
+ * lines_scanned: Newlines observed while scanning, i.e. complete lines fed through the engine.
+ * matches: Matches recorded, after any single match per line dedup.
+ * read_ns: Nanoseconds spent reading and decompressing input. 0 on the memory mapped path, where
+ *     page faults are absorbed into scan time.
+ * scan_ns: Nanoseconds spent inside hs_scan(), excluding time spent in the caller's callback.
+ * callback_ns: Nanoseconds spent inside the caller's result callback.
+ * counters: Opt-in distribution counters, all zero unless enabled with hyperscanner_set_counters().
+ */
+typedef struct hyperscanner_stats {
+    unsigned long long bytes_read;
+    unsigned long long bytes_scanned;
+    unsigned long long lines_scanned;
+    unsigned long long matches;
+    unsigned long long read_ns;
+    unsigned long long scan_ns;
+    unsigned long long callback_ns;
+    hyperscanner_counters_t counters;
+} hyperscanner_stats_t;
+
+/*
+ * Read the monotonic clock as nanoseconds for stage timing deltas.
+ */
+static unsigned long long monotonic_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long) now.tv_sec * 1000000000ULL + (unsigned long long) now.tv_nsec;
+}
+
 /*
  * Callback function used by hyperscanner onEvent in order to send a result to an external caller.
  *
@@ -53,24 +196,361 @@ typedef struct hyperscanner_result {
  */
 typedef void (*hs_event) (hyperscanner_result_t* results, int result_count);
 
+/*
+ * One result record written into a caller provided shared slot table.
+ *
+ * Identical to hyperscanner_result_t except the line is referenced by its offset within the caller
+ * provided arena instead of a pointer, so callers in other runtimes can slice one shared buffer
+ * lazily instead of copying every line out of the batch.
+ *
+ * line_offset: Offset of the NUL terminated line within the caller provided arena.
+ *     Remaining fields match hyperscanner_result_t.
+ */
+typedef struct hyperscanner_shared_result {
+    unsigned int id;
+    unsigned long long line_number;
+    unsigned long long line_offset;
+    unsigned int length;
+    unsigned long long match_start;
+    unsigned long long match_end;
+    unsigned int file_index;
+    unsigned int context;
+    unsigned long long id_mask;
+    unsigned long long byte_offset;
+} hyperscanner_shared_result_t;
+
+/*
+ * Callback function used on the shared transport path to signal a batch is ready.
+ *
+ * The results are already in the caller's slot table and arena, only the count crosses the boundary.
+ *
+ * result_count: How many slots were filled for this batch.
+ */
+typedef void (*hs_shared_event) (int result_count);
+
+/*
+ * Callback function used on the tree scan path to announce each file before its results are emitted.
+ *
+ * The tree path discovers paths natively, so callers use this to build the table that maps the
+ * file_index tag on every result back to a path.
+ *
+ * file_index: The index results from this file are tagged with.
+ * file_name: Location of the file about to be scanned. Only valid for the duration of the callback.
+ */
+typedef void (*hs_path_event) (unsigned int file_index, const char* file_name);
+
+/*
+ * One saved line in the before context ring.
+ *
+ * data: Copy of the line bytes, including the trailing newline when present.
+ * length: How many bytes of data are in use.
+ * capacity: Total capacity of data.
+ * line_number: The index of the saved line within the file.
+ * byte_offset: Absolute byte offset where the saved line begins within the decoded input.
+ * used: Whether the slot holds a line yet.
+ */
+typedef struct context_line {
+    char* data;
+    size_t length;
+    size_t capacity;
+    unsigned long long line_number;
+    unsigned long long byte_offset;
+    int used;
+} context_line_t;
+
 /*
  * Stateful information used to track additional information from Intel Hyperscan during callbacks.
  *
  * match_count: Total number of matches found since starting scan.
  * line_number: The index of the line matched.
- * line: Contents of the line that was matched.
+ * line: Contents of the line currently being scanned. Points into the shared line arena.
+ * line_length: Length of the line currently being scanned, excluding the NUL terminator.
  * callback: Function to call with simplified match information from Intel Hyperscan.
+ * arena: Shared buffer lines are read into and results point into, flushed to the callback before reuse.
+ * arena_size: Total capacity of the arena in bytes.
+ * arena_offset: Start of the unused region of the arena. Only advances past lines that produced results.
+ * dedup_ids: Pattern ids that already produced a result for the current line, or NULL to report every match.
+ *     Used to preserve single match per line semantics when databases are compiled without HS_FLAG_SINGLEMATCH.
+ * dedup_id_count: How many entries are in dedup_ids for the current line.
+ * dedup_line: The line index dedup_ids applies to. Reset whenever a new line produces a match.
+ * line_dedup: Whether to record at most one result per line regardless of how many patterns hit,
+ *     folding later hits into the buffered result's id_mask instead of buffering the line again.
+ * dedup_line_done: Line number plus one of the most recent line that recorded a deduped result,
+ *     0 for none. Offset by one so a zeroed state never skips the first line of a file.
+ * dedup_result_index: Buffered slot of that result, so later hits can fold id mask bits into it.
+ * block: Start of the multi-line block currently being scanned on the block path, NULL on the line path.
+ * block_length: Size of the block currently being scanned.
+ * block_cursor: Position within the block up to which newlines have been counted into line_number.
+ * block_line_start: Start offset of the most recently resolved line within the block.
+ * block_line_end: End offset (exclusive, past the newline) of the most recently resolved line within the block.
+ * block_base: Absolute byte offset of the current block's first byte within the decoded input,
+ *     maintained by the block producers so in-block offsets convert to absolute with one addition.
+ * byte_offset: Absolute byte offset where the most recently resolved line begins, recorded into results.
+ * collector: Optional in-memory sink that receives result batches instead of the callback.
+ *     Used by parallel workers so results can be merged back into file order before emission.
+ * counts: Optional per-pattern-id match counters. When set the scan runs in count only mode:
+ *     matches are tallied without materializing lines, recording results, or invoking the callback.
+ * count_elements: How many entries are in counts. Matches for ids beyond the array are not tallied.
+ * max_match_count: Stop scanning as soon as this many matches are recorded, using Hyperscan's
+ *     callback return contract to halt mid buffer instead of finishing the current scan call.
+ *     Use 0 to indicate no limit.
+ * file_index: Position of the file currently being scanned within the scanned file list.
+ * stats: Optional performance counters filled during the scan. NULL disables all instrumentation.
+ * counters: Optional distribution counters within stats, updated with plain increments on the hot
+ *     path. NULL unless the handle opted in with hyperscanner_set_counters() and stats were requested.
+ * skip_binary: Whether to probe the first decoded bytes for NUL and abandon binary files immediately.
+ * before_context: How many lines preceding each match to report as context results.
+ * after_context: How many lines following each match to report as context results.
+ * context_ring: Ring of the most recent before_context complete lines from earlier blocks, so before
+ *     context can reach back across a block boundary. NULL when no before context was requested.
+ * context_ring_head: Next slot of context_ring to overwrite.
+ * before_offsets: Scratch array of line start offsets used while walking backwards through a block.
+ * reported_through: Line numbers below this were already emitted, as a match or as context, so
+ *     overlapping context regions and repeated matches never duplicate a line.
+ * after_pending: How many after context lines are still owed for the most recent match.
+ * after_cursor: Offset within the current block where the next owed after context line begins.
+ * after_line: Line number of the next owed after context line.
+ * after_id: Pattern id of the match that owes the remaining after context lines.
+ * invert: Whether to report the lines no pattern matched instead of the lines that matched.
+ * invert_cursor: Offset within the current block of the next line not yet reported or excluded.
+ * invert_line: Line number of the line at invert_cursor.
+ * shared_slots: Optional caller provided slot table that receives result batches as arena offsets
+ *     instead of routing them through the pointer based callback. The arena is caller provided too.
+ * shared_callback: Function signalled with only the batch count on the shared transport path.
+ * arena_fixed: Whether the arena is caller owned and must never be reallocated or freed.
  */
 typedef struct hyperscanner_state {
     unsigned long long match_count;
     unsigned long long line_number;
     char* line;
+    size_t line_length;
     hs_event callback;
     unsigned int max_result_index;
     int result_index;
     hyperscanner_result_t* results;
+    char* arena;
+    size_t arena_size;
+    size_t arena_offset;
+    unsigned int* dedup_ids;
+    unsigned int dedup_id_count;
+    unsigned long long dedup_line;
+    int line_dedup;
+    unsigned long long dedup_line_done;
+    int dedup_result_index;
+    const char* block;
+    size_t block_length;
+    size_t block_cursor;
+    size_t block_line_start;
+    size_t block_line_end;
+    unsigned long long block_base;
+    unsigned long long byte_offset;
+    struct result_collector* collector;
+    unsigned long long* counts;
+    unsigned int count_elements;
+    unsigned long long max_match_count;
+    unsigned int file_index;
+    hyperscanner_stats_t* stats;
+    hyperscanner_counters_t* counters;
+    int skip_binary;
+    unsigned int before_context;
+    unsigned int after_context;
+    context_line_t* context_ring;
+    unsigned int context_ring_head;
+    size_t* before_offsets;
+    unsigned long long reported_through;
+    unsigned int after_pending;
+    size_t after_cursor;
+    unsigned long long after_line;
+    unsigned int after_id;
+    int invert;
+    size_t invert_cursor;
+    unsigned long long invert_line;
+    hyperscanner_shared_result_t* shared_slots;
+    hs_shared_event shared_callback;
+    int arena_fixed;
 } hyperscanner_state_t;
 
+/*
+ * Growable in-memory sink for result batches produced by parallel workers.
+ *
+ * results: Collected results. Line pointers are stored as offsets into the lines arena until emission,
+ *     since the arena may be reallocated while the collection grows.
+ * line_offsets: Offset of each collected result line within the lines arena.
+ * count: How many results have been collected.
+ * capacity: How many results can be stored before growing.
+ * lines: Packed copies of every collected line, each NUL terminated.
+ * lines_length: How many bytes of the lines arena are in use.
+ * lines_capacity: Total capacity of the lines arena.
+ * failed: Set when an allocation failed, the scan is stopped and the error is surfaced after joining.
+ */
+typedef struct result_collector {
+    hyperscanner_result_t* results;
+    size_t* line_offsets;
+    size_t count;
+    size_t capacity;
+    char* lines;
+    size_t lines_length;
+    size_t lines_capacity;
+    int failed;
+} result_collector_t;
+
+/*
+ * Persistent scanner handle used to reuse a compiled pattern database and scratch space across multiple files.
+ *
+ * db: A compiled Hyperscan pattern database shared by every scan performed with this handle.
+ * scratch: A Hyperscan scratch space allocated for the database. Not safe to share across simultaneous scans.
+ * elements: How many patterns were compiled into the database.
+ * single_match: Whether every pattern requested HS_FLAG_SINGLEMATCH. The flag is stripped before compiling
+ *     so that block scans report every matching line, and per line dedup is enforced in the callback instead.
+ * stream_db: Lazily compiled HS_MODE_STREAM database, used to scan lines longer than the read buffer
+ *     incrementally. Only compiled the first time such a line is encountered.
+ * patterns: Copies of the compile inputs, retained so the stream database can be compiled on demand.
+ * compile_flags: Flags the block database was compiled with, after any HS_FLAG_SINGLEMATCH stripping.
+ * pattern_ids: Copies of the ids the block database was compiled with.
+ * skip_binary: Whether scans with this handle probe leading bytes for NUL and skip binary files.
+ * before_context: How many lines before each match to report as context results, i.e. grep -B.
+ * after_context: How many lines after each match to report as context results, i.e. grep -A.
+ * invert: Whether scans report the lines no pattern matched instead of the lines that matched, i.e. grep -v.
+ * line_dedup: Whether scans report at most one result per line regardless of how many patterns hit,
+ *     with the ids of every pattern that hit accumulated in the result's id_mask.
+ * counters: Whether stats collecting scans with this handle also fill the distribution counters block.
+ * arena_cache: Line arena recycled from the previous scan, handed to the next scan instead of a fresh
+ *     allocation. Retains any geometric growth, so a handle only ever holds what its workload needed.
+ * arena_cache_size: Size of the recycled arena.
+ * results_cache: Result slot array recycled from the previous scan.
+ * results_cache_count: How many slots are in the recycled result array.
+ * scratch_pool: Cloned scratch spaces retained between scans for parallel workers. Checkout happens
+ *     on the coordinating thread before workers start, and a handle never runs simultaneous scans,
+ *     so the pool needs no locking by contract.
+ * scratch_pool_size: How many clones the pool may retain. Releases beyond the bound free immediately.
+ * scratch_pool_count: How many clones are currently pooled.
+ */
+typedef struct hyperscanner {
+    hs_database_t* db;
+    hs_scratch_t* scratch;
+    unsigned int elements;
+    int single_match;
+    hs_database_t* stream_db;
+    char** patterns;
+    unsigned int* compile_flags;
+    unsigned int* pattern_ids;
+    int skip_binary;
+    unsigned int before_context;
+    unsigned int after_context;
+    int invert;
+    int line_dedup;
+    int counters;
+    char* arena_cache;
+    size_t arena_cache_size;
+    hyperscanner_result_t* results_cache;
+    int results_cache_count;
+    hs_scratch_t** scratch_pool;
+    int scratch_pool_size;
+    int scratch_pool_count;
+} hyperscanner_t;
+
+/*
+ * Append a batch of results to an in-memory collector, copying lines into its packed arena.
+ *
+ * collector: Sink owned by a parallel worker.
+ * results: Batch of results referencing the worker's shared line arena.
+ * result_count: How many entries are in the result batch.
+ */
+static void collect_results(result_collector_t* collector, hyperscanner_result_t* results, int result_count) {
+    if (collector->failed) {
+        return;
+    }
+    for (int index = 0; index < result_count; index++) {
+        if (collector->count == collector->capacity) {
+            size_t new_capacity = collector->capacity ? collector->capacity * 2 : 256;
+            hyperscanner_result_t* new_results = realloc(collector->results, sizeof(hyperscanner_result_t) * new_capacity);
+            size_t* new_offsets = realloc(collector->line_offsets, sizeof(size_t) * new_capacity);
+            if (new_results) {
+                collector->results = new_results;
+            }
+            if (new_offsets) {
+                collector->line_offsets = new_offsets;
+            }
+            if (!new_results || !new_offsets) {
+                collector->failed = 1;
+                return;
+            }
+            collector->capacity = new_capacity;
+        }
+        size_t needed = results[index].length + 1;
+        if (collector->lines_capacity - collector->lines_length < needed) {
+            size_t new_capacity = collector->lines_capacity ? collector->lines_capacity * 2 : 65536;
+            while (new_capacity - collector->lines_length < needed) {
+                new_capacity *= 2;
+            }
+            char* new_lines = realloc(collector->lines, new_capacity);
+            if (!new_lines) {
+                collector->failed = 1;
+                return;
+            }
+            collector->lines = new_lines;
+            collector->lines_capacity = new_capacity;
+        }
+        memcpy(collector->lines + collector->lines_length, results[index].line, needed);
+        collector->results[collector->count] = results[index];
+        collector->line_offsets[collector->count] = collector->lines_length;
+        collector->count++;
+        collector->lines_length += needed;
+    }
+}
+
+/*
+ * Send any pending results to their destination and reset the batch.
+ *
+ * Results go to the external callback, or to an in-memory collector when one is attached for merging.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ */
+static void flush_results(hyperscanner_state_t* state) {
+    if (state->result_index == -1) {
+        return;
+    }
+    if (state->counters) {
+        // Record how full the batch was in even fractions of capacity, so a top heavy histogram
+        // shows buffer_count as the batching bottleneck and a bottom heavy one shows it oversized.
+        unsigned long long filled = (unsigned long long) state->result_index + 1;
+        unsigned long long capacity = (unsigned long long) state->max_result_index + 1;
+        unsigned int bucket = (unsigned int) ((filled * HYPERSCANNER_COUNTER_FILL_BUCKETS - 1) / capacity);
+        if (bucket >= HYPERSCANNER_COUNTER_FILL_BUCKETS) {
+            bucket = HYPERSCANNER_COUNTER_FILL_BUCKETS - 1;
+        }
+        state->counters->batch_fill[bucket]++;
+    }
+    if (state->collector) {
+        collect_results(state->collector, state->results, state->result_index + 1);
+    } else if (state->shared_slots) {
+        // Translate line pointers to arena offsets in place, the lines are already in the caller's arena.
+        int result_count = state->result_index + 1;
+        for (int index = 0; index < result_count; index++) {
+            hyperscanner_result_t* result = &state->results[index];
+            hyperscanner_shared_result_t* slot = &state->shared_slots[index];
+            slot->id = result->id;
+            slot->line_number = result->line_number;
+            slot->line_offset = (unsigned long long) (result->line - state->arena);
+            slot->length = result->length;
+            slot->match_start = result->match_start;
+            slot->match_end = result->match_end;
+            slot->file_index = result->file_index;
+            slot->context = result->context;
+            slot->id_mask = result->id_mask;
+            slot->byte_offset = result->byte_offset;
+        }
+        state->shared_callback(result_count);
+    } else if (state->stats) {
+        unsigned long long begin = monotonic_ns();
+        state->callback(state->results, state->result_index + 1);
+        state->stats->callback_ns += monotonic_ns() - begin;
+    } else {
+        state->callback(state->results, state->result_index + 1);
+    }
+    state->result_index = -1;
+}
+
 /*
  * Callback function used by Intel Hyperscan to pass-through match information to an external callback.
  *
@@ -82,246 +562,3870 @@ typedef struct hyperscanner_state {
  */
 static int hs_callback(unsigned int id, unsigned long long start, unsigned long long end, unsigned int flags, void *ctx) {
     hyperscanner_state_t* state = (hyperscanner_state_t*) ctx;
+
+    // Report at most one result per line when line dedup is enabled, folding later pattern hits
+    // into the buffered result's id mask instead of recording and copying the same line again.
+    // Count only mode keeps its per pattern id tallies and ignores line dedup entirely.
+    if (state->line_dedup && !state->counts && state->dedup_line_done == state->line_number + 1) {
+        if (id < 64 && state->dedup_result_index >= 0) {
+            // A stale index after a flush points at an already emitted slot, which is only ever
+            // reused once a newer line records a result and ends folding for this line.
+            state->results[state->dedup_result_index].id_mask |= 1ULL << id;
+        }
+        return 0;
+    }
+
+    // Enforce single match per pattern per line when requested, since databases are compiled without
+    // HS_FLAG_SINGLEMATCH to keep block scans reporting every matching line.
+    if (state->dedup_ids) {
+        if (state->line_number != state->dedup_line) {
+            state->dedup_line = state->line_number;
+            state->dedup_id_count = 0;
+        }
+        for (unsigned int index = 0; index < state->dedup_id_count; index++) {
+            if (state->dedup_ids[index] == id) {
+                // Already reported for this line, indicate the match was handled without a new result.
+                return 0;
+            }
+        }
+        state->dedup_ids[state->dedup_id_count++] = id;
+    }
     state->match_count++;
+    if (state->counters && id < HYPERSCANNER_COUNTER_IDS) {
+        state->counters->matches_per_id[id]++;
+    }
+
+    // Count only mode tallies the match without recording a result or touching the line arena.
+    if (state->counts) {
+        if (id < state->count_elements) {
+            state->counts[id]++;
+        }
+        return state->max_match_count > 0 && state->match_count >= state->max_match_count;
+    }
 
     // Update the next result in the buffer, without calling the callback, to help reduce possible overhead.
+    // The line is not copied, results reference the shared arena until it is flushed before reuse.
     state->result_index++;
     int result_index = state->result_index;
     state->results[result_index].id = id;
     state->results[result_index].line_number = state->line_number;
-    strcpy(state->results[result_index].line, state->line);
+    state->results[result_index].line = state->line;
+    state->results[result_index].length = (unsigned int) state->line_length;
+    state->results[result_index].match_start = start;
+    state->results[result_index].match_end = end;
+    state->results[result_index].file_index = state->file_index;
+    state->results[result_index].context = HYPERSCANNER_RESULT_MATCH;
+    state->results[result_index].id_mask = id < 64 ? 1ULL << id : 0;
+    state->results[result_index].byte_offset = state->byte_offset;
+    if (state->line_dedup) {
+        state->dedup_line_done = state->line_number + 1;
+        state->dedup_result_index = result_index;
+    }
 
-    // If the result buffer is full, send all results to the external callback and reset.
+    // If the result buffer is full, send all results to the destination and reset.
     if (state->result_index == state->max_result_index) {
-        state->callback(state->results, state->result_index + 1);
-        state->result_index = -1;
+        flush_results(state);
     }
 
-    // Return 0 per Hyperscan documentation to indicate result was handled.
-    return 0;
+    // Return non-zero once the match cap is reached so Hyperscan halts the scan immediately,
+    // otherwise 0 per Hyperscan documentation to indicate result was handled.
+    return state->max_match_count > 0 && state->match_count >= state->max_match_count;
 }
 
 /*
- * Dummy callback function to allow testing library through main() by printing the matched lines.
+ * Ensure the shared line arena has room for an upcoming line, flushing and growing as required.
+ *
+ * Pending results are sent to the callback before the arena rewinds so they never reference
+ * memory that is about to be overwritten.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * needed: How many bytes the next line may require, including the NUL terminator.
  */
-static void event_handler(hyperscanner_result_t* results, int result_count) {
-    for (int index = 0; index < result_count; index++) {
-        // Print off a line similar to grep -n, where it starts with the line number.
-        hyperscanner_result_t result = results[index];
-        printf("%llu:%s", result.line_number, result.line);
+static int arena_reserve(hyperscanner_state_t* state, size_t needed) {
+    if (state->arena_size - state->arena_offset >= needed) {
+        return 0;
+    }
+
+    // Flush pending results and rewind, results must never reference memory that is about to be reused.
+    flush_results(state);
+    state->arena_offset = 0;
+
+    if (needed > state->arena_size) {
+        if (state->arena_fixed) {
+            // The arena is caller owned shared memory, a line larger than it cannot be delivered.
+            return HYPERSCANNER_STATE_MEM;
+        }
+        // A single line is larger than the entire arena, grow geometrically to fit.
+        size_t new_size = state->arena_size;
+        while (new_size < needed) {
+            new_size *= 2;
+        }
+        char* new_arena = realloc(state->arena, new_size);
+        if (!new_arena) {
+            return HYPERSCANNER_STATE_MEM;
+        }
+        state->arena = new_arena;
+        state->arena_size = new_size;
     }
+    return 0;
 }
 
 /*
- * Initialize an Intel Hyperscan database from multiple regex patterns.
+ * Record one context line as a result, materializing it into the shared arena like a match.
  *
- * db: Location of the Intel Hyperscan database in memory. It will be initialized in-place.
- * expressions: Regex patterns to initialize into the database.
- * expression_flags: Flags to set on each regex pattern in order to match. i.e. HS_FLAG_DOTALL
- *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
-* expression_ids: IDs to apply to each regex pattern to group related patterns and prevent separate callbacks.
- *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
- * elements: Size the pattern array.
+ * Context lines flow through the same result batches as matches so ordering is preserved, with
+ * match offsets zeroed and the context field carrying the before/after kind. Lines already emitted,
+ * as a match or by an overlapping context region, are skipped so output never duplicates a line.
+ * Context lines do not count toward the match total or the match cap.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * id: The index of the pattern whose match requested this context line.
+ * data: Start of the line bytes, including the trailing newline when present.
+ * length: How many bytes are in the line.
+ * line_number: The index of the line within the file.
+ * byte_offset: Absolute byte offset where the line begins within the decoded input.
+ * kind: HYPERSCANNER_RESULT_CONTEXT_BEFORE or HYPERSCANNER_RESULT_CONTEXT_AFTER.
  */
-static int init_hs_db(
-    hs_database_t** db,
-    const char* const* expressions,
-    const unsigned int* expression_flags,
-    const unsigned int* expression_ids,
-    int elements
+static int emit_context_line(
+    hyperscanner_state_t* state,
+    unsigned int id,
+    const char* data,
+    size_t length,
+    unsigned long long line_number,
+    unsigned long long byte_offset,
+    unsigned int kind
 ) {
-    int ret = 0;
-
-    hs_compile_error_t* err = NULL;
-    if (hs_compile_multi(expressions, expression_flags, expression_ids, elements, HS_MODE_BLOCK, NULL, db, &err) != HS_SUCCESS) {
-        ret = HYPERSCANNER_COMPILE;
+    if (line_number < state->reported_through) {
+        return 0;
+    }
+    if (arena_reserve(state, length + 1) != 0) {
+        return HYPERSCANNER_STATE_MEM;
     }
+    char* line = state->arena + state->arena_offset;
+    memcpy(line, data, length);
+    line[length] = 0;
+    state->arena_offset += length + 1;
 
-    hs_free_compile_error(err);
-    return ret;
+    state->result_index++;
+    int result_index = state->result_index;
+    state->results[result_index].id = id;
+    state->results[result_index].line_number = line_number;
+    state->results[result_index].line = line;
+    state->results[result_index].length = (unsigned int) length;
+    state->results[result_index].match_start = 0;
+    state->results[result_index].match_end = 0;
+    state->results[result_index].file_index = state->file_index;
+    state->results[result_index].context = kind;
+    state->results[result_index].id_mask = 0;
+    state->results[result_index].byte_offset = byte_offset;
+    if (state->result_index == state->max_result_index) {
+        flush_results(state);
+    }
+    state->reported_through = line_number + 1;
+    return 0;
 }
 
 /*
- * Helper to test regex pattern compilation.
+ * Emit after context lines owed by the most recent match, up to an exclusive line number limit.
  *
- * patterns: Regular expressions to be scanned against every line.
- * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
- *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
- * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
- *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
- * elements: Size the pattern array.
+ * Called with the next match's line as the limit so owed lines always land before it in the batch,
+ * and with no limit at the end of each block. Emission is deferred this way, rather than eager at
+ * match time, so a later match inside the window is reported as a match instead of as context.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * limit: Exclusive upper bound on emitted line numbers. Use ULLONG_MAX for no bound.
  */
-int check_patterns(
-    const char* const* patterns,
-    const unsigned int* pattern_flags,
-    const unsigned int* pattern_ids,
-    const unsigned int elements
-) {
-    int ret = 0;
-    hs_database_t* db = NULL;
-    if (init_hs_db(&db, patterns, pattern_flags, pattern_ids, elements) != 0) {
-        ret = HYPERSCANNER_DB;
+static int flush_after_context(hyperscanner_state_t* state, unsigned long long limit) {
+    while (state->after_pending > 0 && state->after_line < limit && state->after_cursor < state->block_length) {
+        const char* cursor = state->block + state->after_cursor;
+        const char* newline = memchr(cursor, '\n', state->block_length - state->after_cursor);
+        if (!newline) {
+            // The final line of the block is incomplete, the remainder is owed from the next block.
+            break;
+        }
+        size_t line_length = (size_t) (newline - cursor) + 1;
+        int ret = emit_context_line(state, state->after_id, cursor, line_length, state->after_line, state->block_base + state->after_cursor, HYPERSCANNER_RESULT_CONTEXT_AFTER);
+        if (ret != 0) {
+            return ret;
+        }
+        state->after_cursor += line_length;
+        state->after_line++;
+        state->after_pending--;
     }
-    hs_free_database(db);
-    return ret;
+    return 0;
 }
 
 /*
- * Scan a GZIP file using Intel Hyperscan.
+ * Emit the before context lines for the line currently resolved in state as matching.
+ *
+ * Lines within the current block are located by walking backwards with memrchr(), and any deficit
+ * older than the block is served from the ring of trailing lines saved from earlier blocks.
+ * Lines already reported are excluded, so overlapping windows emit each line exactly once.
  *
- * file_name: Location of a local file that can be read line by line.
  * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
- * db: A compiled Hyperscan pattern database.
- * scratch: A per-thread Hyperscan scratch space allocated for this database.
- * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
- * max_match_count: Stop reading the file after requested number of matches found.
+ * id: The index of the pattern that matched the current line.
  */
-int hyperscan_gz(
-    char* file_name,
-    hyperscanner_state_t* state,
-    hs_database_t* db,
-    hs_scratch_t* scratch,
-    int buffer_size,
-    unsigned long long max_match_count
-) {
-    int ret = 0;
-
-    // To avoid manual line scanning, use zlib gz* functions to open files and read into buffer.
-    // For details on manually reading gzips without gzopen: https://zlib.net/zlib_how.html
-    gzFile input_file = gzopen(file_name, "rb");
-    if (input_file == Z_NULL) {
-        // File could not be opened for reading due to permissions, or bad file type.
-        ret = HYPERSCANNER_GZ_OPEN;
+static int emit_before_context(hyperscanner_state_t* state, unsigned int id) {
+    unsigned long long line_number = state->line_number;
+    unsigned long long first = line_number > state->before_context ? line_number - state->before_context : 0;
+    if (first < state->reported_through) {
+        first = state->reported_through;
+    }
+    if (first >= line_number) {
+        return 0;
     }
+    unsigned int needed = (unsigned int) (line_number - first);
 
-    char* buf = malloc(sizeof(char) * buffer_size);
-    while (1) {
-        state->line = gzgets(input_file, buf, buffer_size);
-        if (state->line == Z_NULL) {
-            // EOF or unreadable file.
-            break;
-        }
+    // Collect the starts of the preceding lines within the block, newest first.
+    unsigned int in_block = 0;
+    size_t pos = state->block_line_start;
+    while (in_block < needed && pos > 0) {
+        const char* newline = memrchr(state->block, '\n', pos - 1);
+        state->before_offsets[in_block++] = newline ? (size_t) (newline - state->block) + 1 : 0;
+        pos = state->before_offsets[in_block - 1];
+    }
 
-        // NOTE: Strip off leading null (0) characters or else the string will look like it is empty.
-        // A line may start with any number of leading nulls. Look for the first non-null and update the start.
-        if (buf[0] == 0) {
-            for (int line_start = 1; line_start < buffer_size; line_start++) {
-                if (buf[line_start] != 0) {
-                    state->line = buf + line_start;
-                    break;
+    // Lines older than the block come from the ring saved at earlier block boundaries, oldest first.
+    for (unsigned long long number = first; number + in_block < line_number; number++) {
+        for (unsigned int index = 0; index < state->before_context; index++) {
+            context_line_t* entry = &state->context_ring[index];
+            if (entry->used && entry->line_number == number) {
+                int ret = emit_context_line(state, id, entry->data, entry->length, number, entry->byte_offset, HYPERSCANNER_RESULT_CONTEXT_BEFORE);
+                if (ret != 0) {
+                    return ret;
                 }
+                break;
             }
         }
+    }
 
-        // Hyperscan the buffer up to the end of the current line. ZLIB will read up to a newline or max buffer length.
-        if (hs_scan(db, state->line, strlen(state->line), 0, scratch, hs_callback, state) != HS_SUCCESS) {
-            fprintf(stderr, "ERROR: Unable to scan buffer. Exiting.\n");
-            ret = HYPERSCANNER_SCAN;
-            break;
-        }
-        if (max_match_count > 0 && state->match_count >= max_match_count) {
-            break;
+    // Emit the in-block lines oldest first so results stay in file order.
+    for (unsigned int index = in_block; index > 0; index--) {
+        size_t line_start = state->before_offsets[index - 1];
+        size_t line_end = index > 1 ? state->before_offsets[index - 2] : state->block_line_start;
+        int ret = emit_context_line(state, id, state->block + line_start, line_end - line_start, line_number - index, state->block_base + line_start, HYPERSCANNER_RESULT_CONTEXT_BEFORE);
+        if (ret != 0) {
+            return ret;
         }
-        state->line_number++;
     }
-    gzclose(input_file);
-
-    free(buf);
-    return ret;
+    return 0;
 }
 
 /*
- * Scan a file using Intel Hyperscan for high performance using multiple regexes.
+ * Save one line into the before context ring, overwriting the oldest slot.
  *
- * file_name: Location of a local file that can be read line by line.
- * patterns: Regular expressions to be scanned against every line.
- * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
- *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
- * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
- *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
- * elements: Size the pattern array.
- * on_event: Function to call with simplified match information from Intel Hyperscan.
- * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
- * buffer_count: How many buffers should be used to batch on_event results. Total memory = buffer_size * buffer_count.
- * max_match_count: Stop reading the file after requested number of matches found.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * data: Start of the line bytes, including the trailing newline.
+ * length: How many bytes are in the line.
+ * line_number: The index of the line within the file.
+ * byte_offset: Absolute byte offset where the line begins within the decoded input.
  */
-int hyperscan(
-    char* file_name,
-    const char* const* patterns,
-    const unsigned int* pattern_flags,
-    const unsigned int* pattern_ids,
-    const unsigned int elements,
-    hs_event on_event,
-    const int buffer_size,
-    int buffer_count,
-    unsigned long long max_match_count
-) {
-    if (max_match_count > 0 && max_match_count < buffer_count) {
-        // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
-        buffer_count = max_match_count;
+static int context_ring_push(hyperscanner_state_t* state, const char* data, size_t length, unsigned long long line_number, unsigned long long byte_offset) {
+    context_line_t* entry = &state->context_ring[state->context_ring_head];
+    state->context_ring_head = (state->context_ring_head + 1) % state->before_context;
+    if (entry->capacity < length) {
+        char* new_data = realloc(entry->data, length);
+        if (!new_data) {
+            return HYPERSCANNER_STATE_MEM;
+        }
+        entry->data = new_data;
+        entry->capacity = length;
     }
-    int ret = 0;
+    memcpy(entry->data, data, length);
+    entry->length = length;
+    entry->line_number = line_number;
+    entry->byte_offset = byte_offset;
+    entry->used = 1;
+    return 0;
+}
 
-    // Initialize the Hyperscan database, scratch, and state. If any cannot be created, skip processing.
-    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
-    if (!state) {
-        ret = HYPERSCANNER_STATE_MEM;
-        goto cleanup;
+/*
+ * Refresh the before context ring with the trailing complete lines of a finished block.
+ *
+ * Only the last before_context lines are walked regardless of block size, so the upkeep cost per
+ * multi-megabyte block is a handful of memrchr() calls and small copies.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * block: Start of the block that was just scanned.
+ * block_length: Size of the block.
+ */
+static int context_ring_update(hyperscanner_state_t* state, const char* block, size_t block_length) {
+    const char* last_newline = memrchr(block, '\n', block_length);
+    if (!last_newline) {
+        return 0;
     }
-    state->match_count = 0;
-    state->line_number = 0;
-    state->callback = on_event;
+    size_t end = (size_t) (last_newline - block) + 1;
 
-    state->result_index = -1;
-    state->max_result_index = buffer_count - 1;
-    int max_results = state->max_result_index + 1;
-    state->results = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * max_results);
-    if (!state->results) {
-        ret = HYPERSCANNER_COMPILE_MEM;
-        goto cleanup;
+    // Collect the starts of the trailing complete lines, newest first.
+    unsigned int found = 0;
+    size_t pos = end;
+    while (found < state->before_context && pos > 0) {
+        const char* newline = memrchr(block, '\n', pos - 1);
+        state->before_offsets[found++] = newline ? (size_t) (newline - block) + 1 : 0;
+        pos = state->before_offsets[found - 1];
     }
-    // Allocate the result strings separately due to dynamic size to prevent segfaults.
-    int results_allocated = 0;
-    for (int i = 0; i < max_results; i++) {
-        state->results[i].line = malloc(sizeof(char) * buffer_size);
-        if (!state->results[i].line) {
-            ret = HYPERSCANNER_COMPILE_MEM;
-            goto cleanup;
+
+    // Push oldest first so the ring always holds the newest lines after tiny carry blocks.
+    unsigned long long last_line = state->line_number - 1;
+    for (unsigned int index = found; index > 0; index--) {
+        size_t line_start = state->before_offsets[index - 1];
+        size_t line_end = index > 1 ? state->before_offsets[index - 2] : end;
+        int ret = context_ring_push(state, block + line_start, line_end - line_start, last_line - (index - 1), state->block_base + line_start);
+        if (ret != 0) {
+            return ret;
         }
-        results_allocated++;
     }
-
+    return 0;
+}
+
+/*
+ * Report every clean line between the inverted cursor and a block offset as a result.
+ *
+ * Inverted results reuse the normal result batching with pattern id 0 and zeroed match offsets,
+ * since no pattern produced them. Reported lines count toward the match total and the match cap,
+ * matching grep -v -m semantics where the cap applies to selected lines.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * limit: Offset within the block to report up to, exclusive.
+ *
+ * Returns non-zero when the scan should halt, for the match cap or an allocation failure.
+ */
+static int emit_invert_lines(hyperscanner_state_t* state, size_t limit) {
+    while (state->invert_cursor < limit) {
+        const char* cursor = state->block + state->invert_cursor;
+        const char* newline = memchr(cursor, '\n', limit - state->invert_cursor);
+        size_t line_length = newline ? (size_t) (newline - cursor) + 1 : limit - state->invert_cursor;
+
+        state->match_count++;
+        if (state->counts) {
+            // Count only mode tallies clean lines under id 0 without materializing them.
+            if (state->count_elements > 0) {
+                state->counts[0]++;
+            }
+        } else {
+            if (arena_reserve(state, line_length + 1) != 0) {
+                return 1;
+            }
+            char* line = state->arena + state->arena_offset;
+            memcpy(line, cursor, line_length);
+            line[line_length] = 0;
+            state->arena_offset += line_length + 1;
+
+            state->result_index++;
+            int result_index = state->result_index;
+            state->results[result_index].id = 0;
+            state->results[result_index].line_number = state->invert_line;
+            state->results[result_index].line = line;
+            state->results[result_index].length = (unsigned int) line_length;
+            state->results[result_index].match_start = 0;
+            state->results[result_index].match_end = 0;
+            state->results[result_index].file_index = state->file_index;
+            state->results[result_index].context = HYPERSCANNER_RESULT_MATCH;
+            state->results[result_index].id_mask = 0;
+            state->results[result_index].byte_offset = state->block_base + state->invert_cursor;
+            if (state->result_index == state->max_result_index) {
+                flush_results(state);
+            }
+        }
+        state->invert_cursor += line_length;
+        state->invert_line++;
+        if (state->max_match_count > 0 && state->match_count >= state->max_match_count) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Callback function used by Intel Hyperscan on the block path when inverted matching is enabled.
+ *
+ * Matches only serve to exclude their line: the clean lines between the previous matched line and
+ * this one are reported, the matched line is skipped, and the remainder of the block is reported
+ * at the end of the scan. Lines never materialize unless they are part of the inverted output.
+ *
+ * id: The index of the pattern that matched.
+ * start: The beginning position of the pattern matched within the block.
+ * end: The last position of the pattern matched within the block.
+ * flags: What flags were set on this pattern in order to match. i.e. HS_FLAG_DOTALL
+ * ctx: Pointer to the hyperscanner state passed through hs_scan().
+ */
+static int hs_invert_callback(unsigned int id, unsigned long long start, unsigned long long end, unsigned int flags, void *ctx) {
+    hyperscanner_state_t* state = (hyperscanner_state_t*) ctx;
+    (void) id;
+    (void) start;
+    (void) flags;
+
+    // Attribute the match to the line containing its final byte, as on the normal block path.
+    size_t match_position = end ? (size_t) end - 1 : 0;
+    if (match_position < state->block_line_end) {
+        // Another pattern already excluded this line, nothing further to do.
+        return 0;
+    }
+
+    // Advance the newline accounting and resolve the bounds of the newly excluded line.
+    const char* cursor = state->block + state->block_cursor;
+    const char* match_byte = state->block + match_position;
+    const char* newline;
+    while ((newline = memchr(cursor, '\n', match_byte - cursor)) != NULL) {
+        state->line_number++;
+        cursor = newline + 1;
+    }
+    state->block_cursor = match_position;
+    const char* line_start = memrchr(state->block, '\n', match_position);
+    line_start = line_start ? line_start + 1 : state->block;
+    const char* line_end = memchr(match_byte, '\n', state->block_length - match_position);
+    line_end = line_end ? line_end + 1 : state->block + state->block_length;
+    state->block_line_start = line_start - state->block;
+    state->block_line_end = line_end - state->block;
+
+    // Report the clean lines before the excluded one, then skip past it.
+    int halt = emit_invert_lines(state, state->block_line_start);
+    state->invert_cursor = state->block_line_end;
+    state->invert_line = state->line_number + 1;
+    return halt;
+}
+
+/*
+ * Template for the block path match callbacks, expanded into variants specialized by scan mode.
+ *
+ * Blocks contain many lines, so the line containing each match is resolved lazily: newlines are counted
+ * incrementally up to the match to maintain the line number, and the line bounds are located with
+ * memrchr()/memchr(). The block base converts the resolved line start to an absolute byte offset
+ * without any extra byte accounting. The line is materialized into the shared arena only when it
+ * produced a match, then recorded through the same result buffering as every other path.
+ *
+ * The feature arguments are compile time constants per expansion, so the compiler prunes the count,
+ * dedup, and context branches out of the variants that do not carry them and the dominant modes pay
+ * no per match feature checks. Every variant expands from this single template, so the resolution
+ * and recording logic cannot drift apart.
+ *
+ * name: Function name to define the variant as.
+ * use_counts: Whether the variant retains count only mode support.
+ * use_dedup: Whether the variant retains single match per line and line dedup folding support.
+ * use_context: Whether the variant retains before and after context reporting support.
+ */
+#define HYPERSCANNER_DEFINE_BLOCK_CALLBACK(name, use_counts, use_dedup, use_context)                       \
+static int name(unsigned int id, unsigned long long start, unsigned long long end,                         \
+        unsigned int flags, void *ctx) {                                                                   \
+    hyperscanner_state_t* state = (hyperscanner_state_t*) ctx;                                             \
+    (void) flags;                                                                                          \
+                                                                                                           \
+    /* Attribute matches to the line containing their final byte. Matches arrive ordered by end */         \
+    /* offset, so newlines only ever need to be counted forward from the last accounted position. */       \
+    size_t match_position = end ? (size_t) end - 1 : 0;                                                    \
+    if (match_position >= state->block_line_end) {                                                         \
+        const char* cursor = state->block + state->block_cursor;                                           \
+        const char* match_byte = state->block + match_position;                                            \
+        const char* newline;                                                                               \
+        while ((newline = memchr(cursor, '\n', match_byte - cursor)) != NULL) {                            \
+            state->line_number++;                                                                          \
+            cursor = newline + 1;                                                                          \
+        }                                                                                                  \
+        state->block_cursor = match_position;                                                              \
+                                                                                                           \
+        /* Resolve the bounds of the line containing the match, including the trailing newline. */         \
+        const char* line_start = (use_counts && state->counts) ? NULL : memrchr(state->block, '\n', match_position); \
+        line_start = line_start ? line_start + 1 : state->block;                                           \
+        const char* line_end = memchr(match_byte, '\n', state->block_length - match_position);             \
+        line_end = line_end ? line_end + 1 : state->block + state->block_length;                           \
+        state->block_line_start = line_start - state->block;                                               \
+        state->block_line_end = line_end - state->block;                                                   \
+        state->byte_offset = state->block_base + state->block_line_start;                                  \
+                                                                                                           \
+        /* Emit owed after context from the previous match, then before context for this line, while */    \
+        /* the arena may still flush and rewind without invalidating the upcoming matched line. */         \
+        if (use_context && !state->counts && (state->before_context || state->after_context)) {            \
+            if (flush_after_context(state, state->line_number) != 0                                        \
+                    || emit_before_context(state, id) != 0) {                                              \
+                /* Out of memory, return non-zero to stop the scan per Hyperscan contract. */              \
+                return 1;                                                                                  \
+            }                                                                                              \
+        }                                                                                                  \
+                                                                                                           \
+        /* Materialize the line into the arena with a terminator so results remain plain C strings. */     \
+        /* Count only mode skips the copy entirely, only the line number and bounds matter for dedup. */   \
+        if (!(use_counts && state->counts)) {                                                              \
+            size_t line_length = state->block_line_end - state->block_line_start;                          \
+            if (arena_reserve(state, line_length + 1) != 0) {                                              \
+                /* Out of memory, return non-zero to stop the scan per Hyperscan contract. */              \
+                return 1;                                                                                  \
+            }                                                                                              \
+            state->line = state->arena + state->arena_offset;                                              \
+            memcpy(state->line, line_start, line_length);                                                  \
+            state->line[line_length] = 0;                                                                  \
+            state->line_length = line_length;                                                              \
+            state->arena_offset += line_length + 1;                                                        \
+        }                                                                                                  \
+    }                                                                                                      \
+                                                                                                           \
+    /* Report at most one result per line when line dedup is enabled, folding later pattern hits */        \
+    /* into the buffered result's id mask, mirroring hs_callback() on the line and stream paths. */        \
+    if (use_dedup && state->line_dedup && !state->counts && state->dedup_line_done == state->line_number + 1) { \
+        if (id < 64 && state->dedup_result_index >= 0) {                                                   \
+            state->results[state->dedup_result_index].id_mask |= 1ULL << id;                               \
+        }                                                                                                  \
+        return 0;                                                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /* Enforce single match per pattern per line when requested, since databases are compiled */           \
+    /* without HS_FLAG_SINGLEMATCH to keep block scans reporting every matching line. */                   \
+    if (use_dedup && state->dedup_ids) {                                                                   \
+        if (state->line_number != state->dedup_line) {                                                     \
+            state->dedup_line = state->line_number;                                                        \
+            state->dedup_id_count = 0;                                                                     \
+        }                                                                                                  \
+        int already_reported = 0;                                                                          \
+        for (unsigned int index = 0; index < state->dedup_id_count; index++) {                             \
+            if (state->dedup_ids[index] == id) {                                                           \
+                already_reported = 1;                                                                      \
+                break;                                                                                     \
+            }                                                                                              \
+        }                                                                                                  \
+        if (already_reported) {                                                                            \
+            return 0;                                                                                      \
+        }                                                                                                  \
+        state->dedup_ids[state->dedup_id_count++] = id;                                                    \
+    }                                                                                                      \
+    state->match_count++;                                                                                  \
+    /* Opt-in distribution counters ride on the fully featured variant, selected whenever they are */      \
+    /* enabled, so the specialized variants stay free of instrumentation branches. */                      \
+    if (use_counts && state->counters && id < HYPERSCANNER_COUNTER_IDS) {                                  \
+        state->counters->matches_per_id[id]++;                                                             \
+    }                                                                                                      \
+                                                                                                           \
+    /* Count only mode tallies the match without recording a result or touching the line arena. */         \
+    if (use_counts && state->counts) {                                                                     \
+        if (id < state->count_elements) {                                                                  \
+            state->counts[id]++;                                                                           \
+        }                                                                                                  \
+        return state->max_match_count > 0 && state->match_count >= state->max_match_count;                 \
+    }                                                                                                      \
+                                                                                                           \
+    /* Convert block relative offsets to line relative before recording, so callers receive spans */       \
+    /* that index directly into the returned line regardless of scan path. */                              \
+    unsigned long long line_offset = (unsigned long long) state->block_line_start;                         \
+    unsigned long long relative_start = start > line_offset ? start - line_offset : 0;                     \
+    state->result_index++;                                                                                 \
+    int result_index = state->result_index;                                                                \
+    state->results[result_index].id = id;                                                                  \
+    state->results[result_index].line_number = state->line_number;                                         \
+    state->results[result_index].line = state->line;                                                       \
+    state->results[result_index].length = (unsigned int) state->line_length;                               \
+    state->results[result_index].match_start = relative_start;                                             \
+    state->results[result_index].match_end = end - line_offset;                                            \
+    state->results[result_index].file_index = state->file_index;                                           \
+    state->results[result_index].context = HYPERSCANNER_RESULT_MATCH;                                      \
+    state->results[result_index].id_mask = id < 64 ? 1ULL << id : 0;                                       \
+    state->results[result_index].byte_offset = state->byte_offset;                                         \
+    if (use_dedup && state->line_dedup) {                                                                  \
+        state->dedup_line_done = state->line_number + 1;                                                   \
+        state->dedup_result_index = result_index;                                                          \
+    }                                                                                                      \
+                                                                                                           \
+    /* If the result buffer is full, send all results to the destination and reset. */                     \
+    if (state->result_index == state->max_result_index) {                                                  \
+        flush_results(state);                                                                              \
+    }                                                                                                      \
+                                                                                                           \
+    /* The matched line is now reported, restart the after context window immediately past it. */          \
+    if (use_context && !state->counts && (state->before_context || state->after_context)) {                \
+        state->reported_through = state->line_number + 1;                                                  \
+        if (state->after_context > 0) {                                                                    \
+            state->after_pending = state->after_context;                                                    \
+            state->after_cursor = state->block_line_end;                                                   \
+            state->after_line = state->line_number + 1;                                                    \
+            state->after_id = id;                                                                          \
+        }                                                                                                  \
+    }                                                                                                      \
+    return state->max_match_count > 0 && state->match_count >= state->max_match_count;                     \
+}
+
+// The fully featured variant remains the fallback for count only and context scans.
+HYPERSCANNER_DEFINE_BLOCK_CALLBACK(hs_block_callback, 1, 1, 1)
+
+// Single match per line scans are the Python default, so they get a variant without count or
+// context checks, and plain multi-match scans get one with no feature checks at all.
+HYPERSCANNER_DEFINE_BLOCK_CALLBACK(hs_block_dedup_callback, 0, 1, 0)
+HYPERSCANNER_DEFINE_BLOCK_CALLBACK(hs_block_plain_callback, 0, 0, 0)
+
+/*
+ * Detect the type of a file from its leading magic bytes to route scans to the fastest path.
+ *
+ * file_name: Location of a local file to inspect.
+ *
+ * Returns the detected type. Unreadable or short files report as plain, later reads surface the real error.
+ */
+static hyperscanner_file_type_t detect_file_type(const char* file_name) {
+    hyperscanner_file_type_t file_type = HYPERSCANNER_FILE_PLAIN;
+
+    struct stat file_stat;
+    if (stat(file_name, &file_stat) != 0 || !S_ISREG(file_stat.st_mode)) {
+        // Reading the magic from a FIFO would consume bytes that can never be replayed, so only
+        // regular files are sniffed. Callers route non-regular files to the stream path.
+        return file_type;
+    }
+    FILE* input_file = fopen(file_name, "rb");
+    if (!input_file) {
+        return file_type;
+    }
+    unsigned char magic[4];
+    if (fread(magic, 1, sizeof(magic), input_file) == sizeof(magic)) {
+        if (magic[0] == 0x1f && magic[1] == 0x8b) {
+            file_type = HYPERSCANNER_FILE_GZIP;
+        } else if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+            file_type = HYPERSCANNER_FILE_ZSTD;
+        }
+    }
+    fclose(input_file);
+    return file_type;
+}
+
+/*
+ * Check whether a decoded buffer prefix looks like binary data rather than scannable text.
+ *
+ * Mirrors the grep heuristic: a NUL byte within the probe window marks the data binary, since text
+ * lines never contain NUL and the line arena treats it as a terminator. Core dumps, sqlite files,
+ * and similar blobs in log directories are dense with NUL in their leading bytes.
+ *
+ * data: Start of the decoded data.
+ * length: How many decoded bytes are available. Only the probe window is inspected.
+ */
+static int is_binary_data(const char* data, size_t length) {
+    if (length > HYPERSCANNER_BINARY_PROBE) {
+        length = HYPERSCANNER_BINARY_PROBE;
+    }
+    return memchr(data, '\0', length) != NULL;
+}
+
+/*
+ * Dummy callback function to allow testing library through main() by printing the matched lines.
+ */
+static void event_handler(hyperscanner_result_t* results, int result_count) {
+    for (int index = 0; index < result_count; index++) {
+        // Print off a line similar to grep -n, where it starts with the line number.
+        hyperscanner_result_t result = results[index];
+        printf("%llu:%s", result.line_number, result.line);
+    }
+}
+
+/*
+ * Load a previously serialized Intel Hyperscan database from a cache file.
+ *
+ * db: Location of the Intel Hyperscan database in memory. It will be initialized in-place.
+ * cache_path: Location of a file written by save_db_cache(). Must be keyed by the caller on the
+ *     patterns, flags, ids, and Hyperscan version, since serialized databases have no compatibility checks for them.
+ */
+static int load_db_cache(hs_database_t** db, const char* cache_path) {
+    int ret = -1;
+
+    FILE* cache_file = fopen(cache_path, "rb");
+    if (!cache_file) {
+        // No cache has been written yet, or it is unreadable. Caller falls back to a full compile.
+        return ret;
+    }
+    if (fseek(cache_file, 0, SEEK_END) == 0) {
+        long length = ftell(cache_file);
+        if (length > 0 && fseek(cache_file, 0, SEEK_SET) == 0) {
+            char* bytes = malloc(length);
+            if (bytes) {
+                if (fread(bytes, 1, length, cache_file) == (size_t) length
+                        && hs_deserialize_database(bytes, length, db) == HS_SUCCESS) {
+                    ret = 0;
+                }
+                free(bytes);
+            }
+        }
+    }
+    fclose(cache_file);
+    return ret;
+}
+
+/*
+ * Serialize a compiled Intel Hyperscan database to a cache file for reuse by later processes.
+ *
+ * db: A compiled Hyperscan pattern database.
+ * cache_path: Location to store the serialized database. Written atomically so that simultaneous
+ *     processes never read a partially written cache.
+ */
+static int save_db_cache(const hs_database_t* db, const char* cache_path) {
+    int ret = -1;
+
+    char* bytes = NULL;
+    size_t length = 0;
+    if (hs_serialize_database(db, &bytes, &length) != HS_SUCCESS) {
+        return ret;
+    }
+
+    // Write to a process unique temporary path and rename into place to guarantee readers only see full caches.
+    char temp_path[PATH_MAX];
+    if (snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", cache_path, getpid()) < (int) sizeof(temp_path)) {
+        FILE* cache_file = fopen(temp_path, "wb");
+        if (cache_file) {
+            size_t written = fwrite(bytes, 1, length, cache_file);
+            fclose(cache_file);
+            if (written == length && rename(temp_path, cache_path) == 0) {
+                ret = 0;
+            } else {
+                remove(temp_path);
+            }
+        }
+    }
+    free(bytes);
+    return ret;
+}
+
+/*
+ * Check whether every pattern is a pure literal with no regex metacharacters or escapes.
+ *
+ * expressions: Patterns to inspect.
+ * elements: Size of the pattern array.
+ */
+static int patterns_are_literal(const char* const* expressions, int elements) {
+    for (int index = 0; index < elements; index++) {
+        if (expressions[index][strcspn(expressions[index], "\\^$.[]()?*+{}|")] != '\0') {
+            return 0;
+        }
+    }
+    return elements > 0;
+}
+
+/*
+ * Initialize an Intel Hyperscan database from multiple regex patterns.
+ *
+ * Pattern sets made entirely of fixed strings compile through hs_compile_lit_multi(), which skips
+ * regex parsing and produces leaner databases that scan through Hyperscan's literal matcher.
+ *
+ * db: Location of the Intel Hyperscan database in memory. It will be initialized in-place.
+ * expressions: Regex patterns to initialize into the database.
+ * expression_flags: Flags to set on each regex pattern in order to match. i.e. HS_FLAG_DOTALL
+ *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
+* expression_ids: IDs to apply to each regex pattern to group related patterns and prevent separate callbacks.
+ *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
+ * elements: Size the pattern array.
+ * mode: Hyperscan compile mode, HS_MODE_BLOCK for whole buffer scans or HS_MODE_STREAM for incremental scans.
+ * cache_path: Optional location of a serialized database cache. If readable, the database is deserialized
+ *     instead of compiled, otherwise the compiled database is serialized to the path for later processes.
+ *     Pass NULL to always compile in memory only.
+ */
+static int init_hs_db(
+    hs_database_t** db,
+    const char* const* expressions,
+    const unsigned int* expression_flags,
+    const unsigned int* expression_ids,
+    int elements,
+    const unsigned int mode,
+    const char* cache_path
+) {
+    int ret = 0;
+
+    if (cache_path && load_db_cache(db, cache_path) == 0) {
+        return ret;
+    }
+
+    hs_compile_error_t* err = NULL;
+    hs_error_t compile_ret;
+    if (patterns_are_literal(expressions, elements)) {
+        size_t* lengths = (size_t*) malloc(sizeof(size_t) * elements);
+        unsigned int* literal_flags = (unsigned int*) malloc(sizeof(unsigned int) * elements);
+        if (!lengths || !literal_flags) {
+            free(lengths);
+            free(literal_flags);
+            return HYPERSCANNER_COMPILE_MEM;
+        }
+        for (int index = 0; index < elements; index++) {
+            lengths[index] = strlen(expressions[index]);
+            // Only a small flag subset is valid for literal compiles. DOTALL/MULTILINE alter
+            // metacharacter behavior that literals cannot contain, so dropping them changes nothing.
+            literal_flags[index] = expression_flags[index] & (HS_FLAG_CASELESS | HS_FLAG_SINGLEMATCH | HS_FLAG_SOM_LEFTMOST);
+        }
+        compile_ret = hs_compile_lit_multi(expressions, literal_flags, expression_ids, lengths, elements, mode, NULL, db, &err);
+        free(lengths);
+        free(literal_flags);
+    } else {
+        compile_ret = hs_compile_multi(expressions, expression_flags, expression_ids, elements, mode, NULL, db, &err);
+    }
+    if (compile_ret != HS_SUCCESS) {
+        ret = HYPERSCANNER_COMPILE;
+    }
+
+    hs_free_compile_error(err);
+    if (ret == 0 && cache_path) {
+        // Cache write failures are non-fatal, the in-memory database is already usable.
+        save_db_cache(*db, cache_path);
+    }
+    return ret;
+}
+
+/*
+ * Helper to test regex pattern compilation.
+ *
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
+ * elements: Size the pattern array.
+ */
+int check_patterns(
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements
+) {
+    int ret = 0;
     hs_database_t* db = NULL;
-    hs_scratch_t* scratch = NULL;
-    if (init_hs_db(&db, patterns, pattern_flags, pattern_ids, elements) != 0) {
-        fprintf(stderr, "ERROR: Unable to create database. Exiting.\n");
+    if (init_hs_db(&db, patterns, pattern_flags, pattern_ids, elements, HS_MODE_BLOCK, NULL) != 0) {
         ret = HYPERSCANNER_DB;
-        goto cleanup;
     }
-    if (hs_alloc_scratch(db, &scratch) != HS_SUCCESS) {
+    hs_free_database(db);
+    return ret;
+}
+
+/*
+ * Release a persistent scanner handle and all Hyperscan resources it owns.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create(). May be NULL or partially initialized.
+ */
+void hyperscanner_destroy(hyperscanner_t* scanner) {
+    if (!scanner) {
+        return;
+    }
+    // Ensure the scratch and databases are freed before the handle itself.
+    for (int index = 0; index < scanner->scratch_pool_count; index++) {
+        hs_free_scratch(scanner->scratch_pool[index]);
+    }
+    free(scanner->scratch_pool);
+    hs_free_scratch(scanner->scratch);
+    hs_free_database(scanner->db);
+    hs_free_database(scanner->stream_db);
+    if (scanner->patterns) {
+        for (unsigned int index = 0; index < scanner->elements; index++) {
+            free(scanner->patterns[index]);
+        }
+        free(scanner->patterns);
+    }
+    free(scanner->compile_flags);
+    free(scanner->pattern_ids);
+    free(scanner->arena_cache);
+    free(scanner->results_cache);
+    free(scanner);
+}
+
+/*
+ * Initialize a persistent scanner handle, compiling the pattern database and scratch space once for reuse.
+ *
+ * scanner: Location to store the new handle. Only set on success, and must be released with hyperscanner_destroy().
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
+ * elements: Size the pattern array.
+ * db_cache_path: Optional location of a serialized database cache keyed on the patterns, flags, ids,
+ *     and Hyperscan version. Pass NULL to always compile in memory only.
+ */
+int hyperscanner_create(
+    hyperscanner_t** scanner,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    const char* db_cache_path
+) {
+    int ret = 0;
+
+    hyperscanner_t* new_scanner = (hyperscanner_t*) calloc(1, sizeof(hyperscanner_t));
+    if (!new_scanner) {
+        return HYPERSCANNER_HANDLE_MEM;
+    }
+    new_scanner->elements = elements;
+    new_scanner->scratch_pool_size = HYPERSCANNER_SCRATCH_POOL_SIZE;
+
+    // HS_FLAG_SINGLEMATCH limits a pattern to one match per hs_scan() call, which is one line on the line
+    // path but an entire multi-megabyte block on the block path. Strip it when every pattern requests it,
+    // and enforce the single match per line semantics in the callback instead so both paths report alike.
+    // HS_FLAG_DOTALL is always stripped: dot matching newline was a free performance hint when scans fed
+    // Hyperscan one line at a time, but block scans hand it whole files, where it would let a pattern
+    // like "foo.*bar" span line boundaries and report lines that do not match on their own.
+    unsigned int* compile_flags = NULL;
+    int translate_flags = 0;
+    new_scanner->single_match = elements > 0;
+    for (unsigned int index = 0; index < elements; index++) {
+        if (!(pattern_flags[index] & HS_FLAG_SINGLEMATCH)) {
+            new_scanner->single_match = 0;
+        }
+        if (pattern_flags[index] & HS_FLAG_DOTALL) {
+            translate_flags = 1;
+        }
+    }
+    if (new_scanner->single_match || translate_flags) {
+        compile_flags = (unsigned int*) malloc(sizeof(unsigned int) * elements);
+        if (!compile_flags) {
+            free(new_scanner);
+            return HYPERSCANNER_HANDLE_MEM;
+        }
+        for (unsigned int index = 0; index < elements; index++) {
+            compile_flags[index] = pattern_flags[index] & ~((unsigned int) HS_FLAG_DOTALL);
+            if (new_scanner->single_match) {
+                compile_flags[index] &= ~((unsigned int) HS_FLAG_SINGLEMATCH);
+            }
+        }
+    }
+
+    // Retain copies of the compile inputs so the stream database can be compiled lazily on first use.
+    new_scanner->patterns = (char**) calloc(elements, sizeof(char*));
+    new_scanner->compile_flags = (unsigned int*) malloc(sizeof(unsigned int) * elements);
+    new_scanner->pattern_ids = (unsigned int*) malloc(sizeof(unsigned int) * elements);
+    int copy_failed = !new_scanner->patterns || !new_scanner->compile_flags || !new_scanner->pattern_ids;
+    for (unsigned int index = 0; !copy_failed && index < elements; index++) {
+        new_scanner->patterns[index] = strdup(patterns[index]);
+        new_scanner->compile_flags[index] = compile_flags ? compile_flags[index] : pattern_flags[index];
+        new_scanner->pattern_ids[index] = pattern_ids[index];
+        copy_failed = !new_scanner->patterns[index];
+    }
+    if (copy_failed) {
+        free(compile_flags);
+        hyperscanner_destroy(new_scanner);
+        return HYPERSCANNER_HANDLE_MEM;
+    }
+
+    if (init_hs_db(&new_scanner->db, patterns, compile_flags ? compile_flags : pattern_flags, pattern_ids, elements, HS_MODE_BLOCK, db_cache_path) != 0) {
+        fprintf(stderr, "ERROR: Unable to create database. Exiting.\n");
+        ret = HYPERSCANNER_DB;
+    } else if (hs_alloc_scratch(new_scanner->db, &new_scanner->scratch) != HS_SUCCESS) {
         fprintf(stderr, "ERROR: Unable to allocate scratch space. Exiting.\n");
         ret = HYPERSCANNER_SCRATCH;
-        goto cleanup;
     }
+    free(compile_flags);
 
-    // Route scan based on file type to isolate dynamic buffer allocation scope.
-    ret = hyperscan_gz(file_name, state, db, scratch, buffer_size, max_match_count);
+    if (ret != 0) {
+        // Ensure partially initialized handles are reclaimed so callers only ever track successful handles.
+        hyperscanner_destroy(new_scanner);
+        new_scanner = NULL;
+    }
+    *scanner = new_scanner;
+    return ret;
+}
 
-    // Ensure the buffer is sent if there are any remaining results.
-    if (state->result_index != -1) {
-        state->callback(state->results, state->result_index + 1);
+/*
+ * Toggle binary skip mode on a scanner handle.
+ *
+ * When enabled, scans probe the first decoded bytes of every file for NUL and return
+ * HYPERSCANNER_BINARY immediately instead of streaming unscannable blobs through the engine.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * skip_binary: Non-zero to skip binary files, 0 to scan every file.
+ */
+void hyperscanner_set_binary_skip(hyperscanner_t* scanner, int skip_binary) {
+    scanner->skip_binary = skip_binary;
+}
+
+/*
+ * Configure grep style context line reporting on a scanner handle.
+ *
+ * Context lines are delivered through the normal result batches in file order, with the context
+ * field set to the before/after kind, line numbers populated, and match offsets zeroed. A line is
+ * never reported twice: matches inside a context window report as matches, and overlapping windows
+ * emit each line once. Count only and parallel scans ignore context entirely.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * before_context: How many lines before each match to report, i.e. grep -B.
+ * after_context: How many lines after each match to report, i.e. grep -A.
+ */
+void hyperscanner_set_context(hyperscanner_t* scanner, unsigned int before_context, unsigned int after_context) {
+    scanner->before_context = before_context;
+    scanner->after_context = after_context;
+}
+
+/*
+ * Toggle inverted matching on a scanner handle.
+ *
+ * When enabled, scans report the lines no pattern matched, i.e. grep -v, evaluated natively so
+ * non-matching lines are selected without streaming every line to the caller for filtering.
+ * Inverted results use pattern id 0 with zeroed match offsets, count toward the match cap, and
+ * tally under id 0 in count only mode. Context reporting and parallel scans ignore inversion.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * invert: Non-zero to report non-matching lines, 0 to report matching lines.
+ */
+void hyperscanner_set_invert(hyperscanner_t* scanner, int invert) {
+    scanner->invert = invert;
+}
+
+/*
+ * Toggle per line dedup mode on a scanner handle.
+ *
+ * When enabled, overlapping pattern sets report at most one result per line: the first hit records
+ * the line, and every later hit on the same line folds its pattern id into the result's id_mask
+ * without buffering or copying the line again. The result's id field carries the first pattern
+ * that hit. Count only mode keeps its per pattern id tallies and ignores line dedup.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * line_dedup: Non-zero to report at most one result per line, 0 to report every pattern's match.
+ */
+void hyperscanner_set_line_dedup(hyperscanner_t* scanner, int line_dedup) {
+    scanner->line_dedup = line_dedup;
+}
+
+/*
+ * Bound how many cloned scratch spaces the handle retains between scans.
+ *
+ * Parallel scans clone one scratch per worker from the handle prototype, and the pool recycles the
+ * clones across scans so repeated parallel scans skip the allocation entirely. Cached clones beyond
+ * the new bound are released immediately, and a bound of 0 disables pooling.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * pool_size: How many cloned scratch spaces to retain between scans.
+ */
+void hyperscanner_set_scratch_pool(hyperscanner_t* scanner, int pool_size) {
+    while (scanner->scratch_pool_count > 0) {
+        hs_free_scratch(scanner->scratch_pool[--scanner->scratch_pool_count]);
     }
+    // The checkout array is rebuilt at the new bound by the next release.
+    free(scanner->scratch_pool);
+    scanner->scratch_pool = NULL;
+    scanner->scratch_pool_size = pool_size;
+}
 
-cleanup:
-    // Ensure all buffers are reclaimed before exiting in case usage is multi-threaded.
-    for (int index = 0; index < results_allocated; index++) {
-        free(state->results[index].line);
+/*
+ * Toggle distribution counter collection for stats collecting scans performed with this handle.
+ *
+ * When enabled, scans that request stats also fill the counters block with line length, per pattern
+ * id, batch fill, and buffer refill distributions. Scans that do not request stats are unaffected,
+ * so the hot path cost stays a single pointer check when disabled.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * counters: Whether to fill the distribution counters block during stats collecting scans.
+ */
+void hyperscanner_set_counters(hyperscanner_t* scanner, int counters) {
+    scanner->counters = counters;
+}
+
+/*
+ * Check a worker scratch space out of the handle's pool, cloning from the prototype when empty.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * scratch: Location to store the checked out scratch. Returned with scratch_pool_release().
+ */
+static int scratch_pool_acquire(hyperscanner_t* scanner, hs_scratch_t** scratch) {
+    if (scanner->scratch_pool_count > 0) {
+        *scratch = scanner->scratch_pool[--scanner->scratch_pool_count];
+        return 0;
     }
-    free(state);
+    if (hs_clone_scratch(scanner->scratch, scratch) != HS_SUCCESS) {
+        return HYPERSCANNER_SCRATCH;
+    }
+    return 0;
+}
 
-    // Ensure the scratch, database, and state are freed before exiting.
-    hs_free_scratch(scratch);
-    hs_free_database(db);
+/*
+ * Return a worker scratch space to the handle's pool, freeing it when the pool is already full.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * scratch: Scratch previously checked out with scratch_pool_acquire(). May be NULL.
+ */
+static void scratch_pool_release(hyperscanner_t* scanner, hs_scratch_t* scratch) {
+    if (!scratch) {
+        return;
+    }
+    if (!scanner->scratch_pool && scanner->scratch_pool_size > 0) {
+        scanner->scratch_pool = (hs_scratch_t**) malloc(sizeof(hs_scratch_t*) * scanner->scratch_pool_size);
+    }
+    if (scanner->scratch_pool && scanner->scratch_pool_count < scanner->scratch_pool_size) {
+        scanner->scratch_pool[scanner->scratch_pool_count++] = scratch;
+        return;
+    }
+    hs_free_scratch(scratch);
+}
+
+/*
+ * Lazily compile the HS_MODE_STREAM database used to scan lines longer than the read buffer.
+ *
+ * The existing scratch space is grown in place so it remains valid for both databases.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ */
+static int ensure_stream_database(hyperscanner_t* scanner) {
+    if (scanner->stream_db) {
+        return 0;
+    }
+    if (init_hs_db(&scanner->stream_db, (const char* const*) scanner->patterns, scanner->compile_flags, scanner->pattern_ids, scanner->elements, HS_MODE_STREAM, NULL) != 0) {
+        fprintf(stderr, "ERROR: Unable to create streaming database. Exiting.\n");
+        return HYPERSCANNER_DB;
+    }
+    if (hs_alloc_scratch(scanner->stream_db, &scanner->scratch) != HS_SUCCESS) {
+        fprintf(stderr, "ERROR: Unable to allocate scratch space. Exiting.\n");
+        return HYPERSCANNER_SCRATCH;
+    }
+    return 0;
+}
+
+// Forward declaration, shared with the memory mapped scanning path defined later.
+static int scan_block(hyperscanner_state_t* state, hs_database_t* db, hs_scratch_t* scratch, const char* block, size_t block_length);
+
+/*
+ * Append bytes to the growable carry buffer holding a line that spans pipeline buffers.
+ *
+ * carry: Location of the carry buffer. May be reallocated to fit.
+ * length: How many bytes of the carry buffer are in use. Updated after appending.
+ * capacity: Total capacity of the carry buffer. Updated when the buffer grows.
+ * data: Bytes to append.
+ * data_length: How many bytes to append.
+ */
+static int carry_append(char** carry, size_t* length, size_t* capacity, const char* data, size_t data_length) {
+    if (*capacity - *length < data_length) {
+        size_t new_capacity = *capacity ? *capacity : 65536;
+        while (new_capacity - *length < data_length) {
+            new_capacity *= 2;
+        }
+        char* new_carry = realloc(*carry, new_capacity);
+        if (!new_carry) {
+            return HYPERSCANNER_STATE_MEM;
+        }
+        *carry = new_carry;
+        *capacity = new_capacity;
+    }
+    memcpy(*carry + *length, data, data_length);
+    *length += data_length;
+    return 0;
+}
+
+/*
+ * Function used by the scan pipeline reader thread to fill a buffer with decoded bytes.
+ *
+ * ctx: Reader specific context, e.g. open file handles and decoder state.
+ * buffer: Location to store the decoded bytes.
+ * capacity: How many bytes the buffer can hold.
+ * error: Location to store a hyperscanner return code when reading fails.
+ *
+ * Returns how many bytes were produced. 0 indicates end of input or failure.
+ */
+typedef size_t (*pipeline_fill) (void* ctx, char* buffer, size_t capacity, int* error);
+
+/*
+ * Buffer ring handed off between a reader thread and the scanning thread, so that decompression and
+ * file reads overlap with hs_scan() instead of strictly alternating with it. The reader runs ahead
+ * until every slot is full, keeping several block sized reads in flight so a storage stall has to
+ * outlast the whole ring before the scanner ever idles.
+ *
+ * lock: Guards the slot states below.
+ * readable: Signaled by the reader when a buffer becomes full.
+ * writable: Signaled by the scanner when a buffer becomes free, and on shutdown.
+ * buffers: The ring of handoff buffers, each holding one block of decoded data.
+ * lengths: How many bytes are in each buffer. A full buffer with length 0 marks end of input.
+ * full: Whether each buffer is filled and waiting to be scanned.
+ * stop: Set by the scanner to halt the reader early, e.g. on error or match cap.
+ * read_error: Return code from the reader when producing bytes failed.
+ * fill: Function the reader uses to produce decoded bytes.
+ * fill_ctx: Context passed through to fill.
+ * stats: Optional counters receiving reader thread read/decompress time. NULL disables timing.
+ * counters: Optional distribution counters receiving the buffer refill total. NULL disables counting.
+ */
+typedef struct pipeline {
+    pthread_mutex_t lock;
+    pthread_cond_t readable;
+    pthread_cond_t writable;
+    char* buffers[HYPERSCANNER_PIPELINE_DEPTH];
+    size_t lengths[HYPERSCANNER_PIPELINE_DEPTH];
+    int full[HYPERSCANNER_PIPELINE_DEPTH];
+    int stop;
+    int read_error;
+    pipeline_fill fill;
+    void* fill_ctx;
+    hyperscanner_stats_t* stats;
+    hyperscanner_counters_t* counters;
+} pipeline_t;
+
+/*
+ * Thread entry point filling pipeline buffers ahead of the scanner until end of input or shutdown.
+ *
+ * arg: Pointer to the pipeline being fed.
+ */
+static void* pipeline_reader_main(void* arg) {
+    pipeline_t* pipeline = (pipeline_t*) arg;
+    int slot = 0;
+    unsigned long long read_ns = 0;
+    unsigned long long refills = 0;
+    while (1) {
+        pthread_mutex_lock(&pipeline->lock);
+        while (pipeline->full[slot] && !pipeline->stop) {
+            pthread_cond_wait(&pipeline->writable, &pipeline->lock);
+        }
+        if (pipeline->stop) {
+            pthread_mutex_unlock(&pipeline->lock);
+            break;
+        }
+        pthread_mutex_unlock(&pipeline->lock);
+
+        // Produce the next block outside the lock, this is the expensive read/decompress stage.
+        int error = 0;
+        unsigned long long begin = pipeline->stats ? monotonic_ns() : 0;
+        size_t length = pipeline->fill(pipeline->fill_ctx, pipeline->buffers[slot], HYPERSCANNER_BLOCK_SIZE, &error);
+        if (pipeline->stats) {
+            read_ns += monotonic_ns() - begin;
+        }
+        if (length > 0) {
+            refills++;
+        }
+
+        pthread_mutex_lock(&pipeline->lock);
+        pipeline->lengths[slot] = length;
+        pipeline->full[slot] = 1;
+        if (error != 0) {
+            pipeline->read_error = error;
+        }
+        pthread_cond_signal(&pipeline->readable);
+        pthread_mutex_unlock(&pipeline->lock);
+        if (length == 0 || error != 0) {
+            // The empty buffer doubles as the end of input marker for the scanner.
+            break;
+        }
+        slot = (slot + 1) % HYPERSCANNER_PIPELINE_DEPTH;
+    }
+    if (pipeline->stats) {
+        // Published once before exit, the scanning thread only reads totals after joining this thread.
+        pipeline->stats->read_ns += read_ns;
+    }
+    if (pipeline->counters) {
+        pipeline->counters->buffer_refills += refills;
+    }
+    return NULL;
+}
+
+/*
+ * Open a Hyperscan stream for a line that outgrew a full block, so memory use stays bounded.
+ *
+ * The collected line prefix is materialized into the arena as the reported line content, then fed
+ * to the stream. The rest of the line is streamed buffer by buffer without ever being assembled.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * stream: Location to store the opened stream.
+ * prefix: Start of the oversized line collected so far.
+ * prefix_length: How many bytes of the line have been collected.
+ * arena_used: Location to store how many arena bytes the materialized prefix consumed.
+ */
+static int begin_line_stream(
+    hyperscanner_state_t* state,
+    hyperscanner_t* scanner,
+    hs_stream_t** stream,
+    const char* prefix,
+    size_t prefix_length,
+    size_t* arena_used
+) {
+    int ret = ensure_stream_database(scanner);
+    if (ret != 0) {
+        return ret;
+    }
+    if (hs_open_stream(scanner->stream_db, 0, stream) != HS_SUCCESS) {
+        return HYPERSCANNER_SCAN;
+    }
+
+    *arena_used = 0;
+    if (!state->counts) {
+        // The full line is never assembled, results report the collected prefix as the line content.
+        if (arena_reserve(state, prefix_length + 1) != 0) {
+            hs_close_stream(*stream, scanner->scratch, NULL, NULL);
+            *stream = NULL;
+            return HYPERSCANNER_STATE_MEM;
+        }
+        state->line = state->arena + state->arena_offset;
+        memcpy(state->line, prefix, prefix_length);
+        state->line[prefix_length] = 0;
+        state->line_length = prefix_length;
+        *arena_used = prefix_length + 1;
+    }
+
+    hs_error_t scan_ret = hs_scan_stream(*stream, prefix, prefix_length, 0, scanner->scratch, hs_callback, state);
+    if (scan_ret != HS_SUCCESS && scan_ret != HS_SCAN_TERMINATED) {
+        return HYPERSCANNER_SCAN;
+    }
+    return 0;
+}
+
+/*
+ * Scan decoded data produced by a reader thread, overlapping reads with scanning via a buffer ring.
+ *
+ * Buffers are scanned up to their last complete line; a line spanning buffers is assembled in a small
+ * carry buffer and scanned as its own block, so patterns never straddle a scan boundary. A line that
+ * outgrows a full block switches to Hyperscan streaming mode instead of growing the carry without
+ * bound. The reader fills ring slots ahead of the scanner through a lightweight condition variable
+ * handoff, keeping several block sized reads in flight to hide storage latency on cold cache scans.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * fill: Function the reader thread uses to produce decoded bytes.
+ * fill_ctx: Context passed through to fill.
+ * max_match_count: Stop scanning after requested number of matches found.
+ */
+static int scan_pipeline(
+    hyperscanner_state_t* state,
+    hyperscanner_t* scanner,
+    pipeline_fill fill,
+    void* fill_ctx,
+    unsigned long long max_match_count
+) {
+    int ret = 0;
+    int finished = 0;
+    char* carry = NULL;
+    size_t carry_length = 0;
+    size_t carry_capacity = 0;
+    hs_stream_t* line_stream = NULL;
+    size_t stream_arena_used = 0;
+    unsigned long long stream_previous_matches = 0;
+    int first_buffer = 1;
+    // Absolute decoded offsets: stream_base tracks the start of the current buffer within the
+    // decoded stream, carry_base the start of the line being assembled across buffers.
+    unsigned long long stream_base = 0;
+    unsigned long long carry_base = 0;
+
+    pipeline_t pipeline;
+    memset(&pipeline, 0, sizeof(pipeline));
+    pthread_mutex_init(&pipeline.lock, NULL);
+    pthread_cond_init(&pipeline.readable, NULL);
+    pthread_cond_init(&pipeline.writable, NULL);
+    pipeline.fill = fill;
+    pipeline.fill_ctx = fill_ctx;
+    pipeline.stats = state->stats;
+    pipeline.counters = state->counters;
+    int buffers_ready = 1;
+    for (int index = 0; index < HYPERSCANNER_PIPELINE_DEPTH; index++) {
+        pipeline.buffers[index] = malloc(HYPERSCANNER_BLOCK_SIZE);
+        if (!pipeline.buffers[index]) {
+            buffers_ready = 0;
+        }
+    }
+    pthread_t reader;
+    int reader_started = 0;
+    if (!buffers_ready || pthread_create(&reader, NULL, pipeline_reader_main, &pipeline) != 0) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    reader_started = 1;
+
+    int slot = 0;
+    while (ret == 0) {
+        // Wait for the reader to hand over the next full buffer. Buffers are produced and consumed
+        // in the same ring order, so the slots always line up.
+        pthread_mutex_lock(&pipeline.lock);
+        while (!pipeline.full[slot]) {
+            pthread_cond_wait(&pipeline.readable, &pipeline.lock);
+        }
+        size_t length = pipeline.lengths[slot];
+        pthread_mutex_unlock(&pipeline.lock);
+        if (length == 0) {
+            finished = 1;
+            break;
+        }
+
+        const char* data = pipeline.buffers[slot];
+        size_t pos = 0;
+        if (first_buffer) {
+            first_buffer = 0;
+            if (state->skip_binary && is_binary_data(data, length)) {
+                // Abandon unscannable blobs before any engine work, the remaining branches are
+                // no-ops on the first buffer and the loop exits after releasing the slot.
+                ret = HYPERSCANNER_BINARY;
+            }
+        }
+        if (line_stream) {
+            // An oversized line is in progress, keep streaming until its newline arrives.
+            const char* first_newline = memchr(data, '\n', length);
+            size_t feed = first_newline ? (size_t) (first_newline - data) + 1 : length;
+            hs_error_t scan_ret = hs_scan_stream(line_stream, data, feed, 0, scanner->scratch, hs_callback, state);
+            if (scan_ret != HS_SUCCESS && scan_ret != HS_SCAN_TERMINATED) {
+                ret = HYPERSCANNER_SCAN;
+            } else if (first_newline) {
+                // The line is complete, deliver end of data matches and return to block scanning.
+                if (hs_close_stream(line_stream, scanner->scratch, hs_callback, state) != HS_SUCCESS) {
+                    ret = HYPERSCANNER_SCAN;
+                }
+                line_stream = NULL;
+                if (state->match_count != stream_previous_matches) {
+                    // The line produced results referencing the arena prefix, keep it until flushed.
+                    state->arena_offset += stream_arena_used;
+                }
+                state->line_number++;
+            }
+            pos = feed;
+        } else if (carry_length > 0) {
+            const char* first_newline = memchr(data, '\n', length);
+            if (!first_newline && carry_length + length > HYPERSCANNER_BLOCK_SIZE) {
+                // The line outgrew a full block, stream the remainder in fixed memory instead of
+                // growing the carry without bound.
+                stream_previous_matches = state->match_count;
+                state->byte_offset = carry_base;
+                ret = begin_line_stream(state, scanner, &line_stream, carry, carry_length, &stream_arena_used);
+                carry_length = 0;
+                if (ret == 0) {
+                    hs_error_t scan_ret = hs_scan_stream(line_stream, data, length, 0, scanner->scratch, hs_callback, state);
+                    if (scan_ret != HS_SUCCESS && scan_ret != HS_SCAN_TERMINATED) {
+                        ret = HYPERSCANNER_SCAN;
+                    }
+                }
+                pos = length;
+            } else {
+                // Complete the line spanning the previous buffer before scanning this one in place.
+                size_t joined = first_newline ? (size_t) (first_newline - data) + 1 : length;
+                ret = carry_append(&carry, &carry_length, &carry_capacity, data, joined);
+                if (ret == 0 && first_newline) {
+                    state->block_base = carry_base;
+                    ret = scan_block(state, scanner->db, scanner->scratch, carry, carry_length);
+                    carry_length = 0;
+                }
+                pos = joined;
+            }
+        }
+        if (ret == 0 && pos < length) {
+            const char* last_newline = memrchr(data + pos, '\n', length - pos);
+            if (last_newline) {
+                size_t scan_length = (size_t) (last_newline - (data + pos)) + 1;
+                state->block_base = stream_base + pos;
+                ret = scan_block(state, scanner->db, scanner->scratch, data + pos, scan_length);
+                pos += scan_length;
+            }
+            if (ret == 0 && pos < length) {
+                // Keep the trailing partial line until the next buffer completes it.
+                carry_base = stream_base + pos;
+                ret = carry_append(&carry, &carry_length, &carry_capacity, data + pos, length - pos);
+            }
+        }
+
+        // Release the buffer back to the reader before moving to the next slot in the ring.
+        pthread_mutex_lock(&pipeline.lock);
+        pipeline.full[slot] = 0;
+        pthread_cond_signal(&pipeline.writable);
+        pthread_mutex_unlock(&pipeline.lock);
+        stream_base += length;
+        if (max_match_count > 0 && state->match_count >= max_match_count) {
+            break;
+        }
+        slot = (slot + 1) % HYPERSCANNER_PIPELINE_DEPTH;
+    }
+
+cleanup:
+    if (reader_started) {
+        pthread_mutex_lock(&pipeline.lock);
+        pipeline.stop = 1;
+        pthread_cond_signal(&pipeline.writable);
+        pthread_mutex_unlock(&pipeline.lock);
+        pthread_join(reader, NULL);
+    }
+    if (line_stream) {
+        // The input ended mid line, deliver any end of data matches for the streamed final line.
+        if (hs_close_stream(line_stream, scanner->scratch, hs_callback, state) != HS_SUCCESS && ret == 0) {
+            ret = HYPERSCANNER_SCAN;
+        }
+        if (state->match_count != stream_previous_matches) {
+            state->arena_offset += stream_arena_used;
+        }
+    }
+    if (ret == 0 && pipeline.read_error != 0) {
+        ret = pipeline.read_error;
+    } else if (ret == 0 && finished && carry_length > 0) {
+        // The file does not end with a newline, scan the remainder as the final line.
+        state->block_base = carry_base;
+        ret = scan_block(state, scanner->db, scanner->scratch, carry, carry_length);
+    }
+    free(carry);
+    for (int index = 0; index < HYPERSCANNER_PIPELINE_DEPTH; index++) {
+        free(pipeline.buffers[index]);
+    }
+    pthread_mutex_destroy(&pipeline.lock);
+    pthread_cond_destroy(&pipeline.readable);
+    pthread_cond_destroy(&pipeline.writable);
+    return ret;
+}
+
+/*
+ * Reader context for decoding ZSTD files on the pipeline reader thread.
+ *
+ * input_file: Open compressed file being read.
+ * dstream: libzstd streaming decoder. Concatenated multi-frame archives decode transparently.
+ * in_buffer: Compressed read buffer sized by ZSTD_DStreamInSize().
+ * in_capacity: Total capacity of the compressed read buffer.
+ * input: Decoder view of the compressed buffer, persisted across fills mid consumption.
+ * bytes_read: Total compressed bytes read from the file, for scan statistics.
+ */
+typedef struct zstd_reader {
+    FILE* input_file;
+    ZSTD_DStream* dstream;
+    char* in_buffer;
+    size_t in_capacity;
+    ZSTD_inBuffer input;
+    unsigned long long bytes_read;
+} zstd_reader_t;
+
+/*
+ * Fill a pipeline buffer with decoded bytes from a ZSTD file. Runs on the reader thread.
+ *
+ * ctx: zstd_reader_t with the open file and decoder state.
+ * buffer: Location to store the decoded bytes.
+ * capacity: How many bytes the buffer can hold.
+ * error: Location to store a hyperscanner return code when decoding fails.
+ */
+static size_t zstd_fill(void* ctx, char* buffer, size_t capacity, int* error) {
+    zstd_reader_t* reader = (zstd_reader_t*) ctx;
+
+    ZSTD_outBuffer output = {buffer, capacity, 0};
+    while (output.pos < output.size) {
+        if (reader->input.pos == reader->input.size) {
+            size_t read_length = fread(reader->in_buffer, 1, reader->in_capacity, reader->input_file);
+            if (read_length == 0) {
+                if (!feof(reader->input_file)) {
+                    *error = HYPERSCANNER_DECODE;
+                }
+                break;
+            }
+            reader->input.src = reader->in_buffer;
+            reader->input.size = read_length;
+            reader->input.pos = 0;
+            reader->bytes_read += read_length;
+            // Hint the kernel to load the next compressed span while this one decompresses and scans.
+            posix_fadvise(fileno(reader->input_file), ftell(reader->input_file), (off_t) (reader->in_capacity * 4), POSIX_FADV_WILLNEED);
+        }
+        size_t zstd_ret = ZSTD_decompressStream(reader->dstream, &output, &reader->input);
+        if (ZSTD_isError(zstd_ret)) {
+            fprintf(stderr, "ERROR: Unable to decompress buffer: %s. Exiting.\n", ZSTD_getErrorName(zstd_ret));
+            *error = HYPERSCANNER_DECODE;
+            break;
+        }
+    }
+    return output.pos;
+}
+
+/*
+ * Scan a ZSTD compressed file using Intel Hyperscan by streaming frames directly through libzstd.
+ *
+ * Bypasses the gz* emulation layer: a reader thread decompresses with ZSTD_decompressStream() into
+ * block sized buffers while this thread runs hs_scan() on the previously decoded one, so decoding
+ * and scanning overlap instead of strictly alternating.
+ *
+ * file_name: Location of a local ZSTD compressed file.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan_zstd(
+    char* file_name,
+    hyperscanner_state_t* state,
+    hyperscanner_t* scanner,
+    unsigned long long max_match_count
+) {
+    int ret = 0;
+
+    zstd_reader_t reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.input_file = fopen(file_name, "rb");
+    if (!reader.input_file) {
+        // File could not be opened for reading due to permissions, or bad file type.
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    reader.dstream = ZSTD_createDStream();
+    reader.in_capacity = ZSTD_DStreamInSize();
+    reader.in_buffer = malloc(reader.in_capacity);
+    if (!reader.dstream || !reader.in_buffer) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    ZSTD_initDStream(reader.dstream);
+
+    ret = scan_pipeline(state, scanner, zstd_fill, &reader, max_match_count);
+    if (state->stats) {
+        state->stats->bytes_read += reader.bytes_read;
+    }
+
+cleanup:
+    ZSTD_freeDStream(reader.dstream);
+    free(reader.in_buffer);
+    fclose(reader.input_file);
+    return ret;
+}
+
+/*
+ * Reader context for decoding GZIP (or uncompressed fallback) files on the pipeline reader thread.
+ *
+ * input_file: Open file being read through the gz* wrapper.
+ * fd: Advisory descriptor on the same file used for readahead hints, or -1 when unavailable.
+ */
+typedef struct gz_reader {
+    gzFile input_file;
+    int fd;
+} gz_reader_t;
+
+/*
+ * Fill a pipeline buffer with decoded bytes from a GZIP file. Runs on the reader thread.
+ *
+ * ctx: gz_reader_t with the open file.
+ * buffer: Location to store the decoded bytes.
+ * capacity: How many bytes the buffer can hold.
+ * error: Location to store a hyperscanner return code when decoding fails.
+ */
+static size_t gz_fill(void* ctx, char* buffer, size_t capacity, int* error) {
+    gz_reader_t* reader = (gz_reader_t*) ctx;
+
+    int read_length = gzread(reader->input_file, buffer, (unsigned int) capacity);
+    if (read_length < 0) {
+        *error = HYPERSCANNER_DECODE;
+        return 0;
+    }
+    if (reader->fd >= 0) {
+        // Hint the kernel to load the next compressed span while this block decodes and scans.
+        posix_fadvise(reader->fd, (off_t) gzoffset(reader->input_file), HYPERSCANNER_BLOCK_SIZE, POSIX_FADV_WILLNEED);
+    }
+    return (size_t) read_length;
+}
+
+/*
+ * Scan a GZIP file using Intel Hyperscan.
+ *
+ * Reads large raw blocks with gzread() on a reader thread instead of copying line by line through
+ * gzgets(), segments them at newline boundaries with memchr()/memrchr(), and feeds whole multi-line
+ * blocks to hs_scan(). Lines longer than a block switch to streaming mode so memory stays bounded.
+ *
+ * file_name: Location of a local file that can be read line by line.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * buffer_size: Retained for compatibility, block sizing is fixed at HYPERSCANNER_BLOCK_SIZE.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan_gz(
+    char* file_name,
+    hyperscanner_state_t* state,
+    hyperscanner_t* scanner,
+    int buffer_size,
+    unsigned long long max_match_count
+) {
+    (void) buffer_size;
+
+    // Use zlib compatible gz* functions to open files, transparently decoding both gzip and plain data.
+    gz_reader_t reader;
+    reader.input_file = gzopen(file_name, "rb");
+    if (reader.input_file == Z_NULL) {
+        // File could not be opened for reading due to permissions, or bad file type.
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    // Grow the internal decode buffer, the default is far too small for block sized reads.
+    gzbuffer(reader.input_file, 128 * 1024);
+    // Separate advisory descriptor for readahead hints, the gz* wrapper does not expose its own.
+    reader.fd = open(file_name, O_RDONLY);
+
+    int ret = scan_pipeline(state, scanner, gz_fill, &reader, max_match_count);
+
+    if (state->stats) {
+        // gzoffset() reports the compressed position, i.e. raw bytes pulled from storage.
+        state->stats->bytes_read += (unsigned long long) gzoffset(reader.input_file);
+    }
+    if (reader.fd >= 0) {
+        close(reader.fd);
+    }
+    gzclose(reader.input_file);
+    return ret;
+}
+
+/*
+ * Reader context for decoding a descriptor stream on the pipeline reader thread.
+ *
+ * input_file: Open stream being read through the gz* wrapper.
+ * peek: Decoded bytes consumed while probing the stream type, replayed ahead of further reads.
+ * peek_length: How many peeked bytes remain to be replayed.
+ */
+typedef struct fd_reader {
+    gzFile input_file;
+    unsigned char peek[4];
+    size_t peek_length;
+} fd_reader_t;
+
+/*
+ * Fill a pipeline buffer with decoded bytes from a descriptor stream. Runs on the reader thread.
+ *
+ * The bytes consumed by the stream type probe are replayed at the front of the first buffer, so
+ * the scan sees the stream from its first byte.
+ *
+ * ctx: fd_reader_t with the open stream.
+ * buffer: Location to store the decoded bytes.
+ * capacity: How many bytes the buffer can hold.
+ * error: Location to store a hyperscanner return code when decoding fails.
+ */
+static size_t fd_fill(void* ctx, char* buffer, size_t capacity, int* error) {
+    fd_reader_t* reader = (fd_reader_t*) ctx;
+
+    size_t offset = 0;
+    if (reader->peek_length > 0) {
+        memcpy(buffer, reader->peek, reader->peek_length);
+        offset = reader->peek_length;
+        reader->peek_length = 0;
+    }
+    int read_length = gzread(reader->input_file, buffer + offset, (unsigned int) (capacity - offset));
+    if (read_length < 0) {
+        *error = HYPERSCANNER_DECODE;
+        return 0;
+    }
+    return offset + (size_t) read_length;
+}
+
+/*
+ * Reader context for decoding a ZSTD descriptor stream on the pipeline reader thread.
+ *
+ * The compressed bytes arrive untouched through the gz* wrapper, which passes unrecognized data
+ * through raw, and frames decode with ZSTD_decompressStream() exactly like path based zstd scans.
+ *
+ * input_file: Open stream delivering the raw compressed bytes.
+ * dstream: libzstd streaming decoder. Concatenated multi-frame streams decode transparently.
+ * in_buffer: Compressed read buffer sized by ZSTD_DStreamInSize().
+ * in_capacity: Total capacity of the compressed read buffer.
+ * input: Decoder view of the compressed buffer, persisted across fills mid consumption.
+ */
+typedef struct zstd_fd_reader {
+    gzFile input_file;
+    ZSTD_DStream* dstream;
+    char* in_buffer;
+    size_t in_capacity;
+    ZSTD_inBuffer input;
+} zstd_fd_reader_t;
+
+/*
+ * Fill a pipeline buffer with decoded bytes from a ZSTD descriptor stream. Runs on the reader thread.
+ *
+ * ctx: zstd_fd_reader_t with the open stream and decoder state.
+ * buffer: Location to store the decoded bytes.
+ * capacity: How many bytes the buffer can hold.
+ * error: Location to store a hyperscanner return code when decoding fails.
+ */
+static size_t zstd_fd_fill(void* ctx, char* buffer, size_t capacity, int* error) {
+    zstd_fd_reader_t* reader = (zstd_fd_reader_t*) ctx;
+
+    ZSTD_outBuffer output = {buffer, capacity, 0};
+    while (output.pos < output.size) {
+        if (reader->input.pos == reader->input.size) {
+            int read_length = gzread(reader->input_file, reader->in_buffer, (unsigned int) reader->in_capacity);
+            if (read_length < 0) {
+                *error = HYPERSCANNER_DECODE;
+                break;
+            }
+            if (read_length == 0) {
+                break;
+            }
+            reader->input.src = reader->in_buffer;
+            reader->input.size = (size_t) read_length;
+            reader->input.pos = 0;
+        }
+        size_t zstd_ret = ZSTD_decompressStream(reader->dstream, &output, &reader->input);
+        if (ZSTD_isError(zstd_ret)) {
+            fprintf(stderr, "ERROR: Unable to decompress buffer: %s. Exiting.\n", ZSTD_getErrorName(zstd_ret));
+            *error = HYPERSCANNER_DECODE;
+            break;
+        }
+    }
+    return output.pos;
+}
+
+/*
+ * Scan an open descriptor as an unbounded, unseekable stream, e.g. stdin or a pipe from another process.
+ *
+ * The descriptor is duplicated and handed to gzdopen(), so gzip and plain bytes decode transparently
+ * exactly as path based scans do, and the caller's descriptor survives the gzclose(). The first bytes
+ * are probed for the zstd magic, routing zstd streams through libzstd directly like path based zstd
+ * scans instead of relying on the gz* wrapper. Blocks flow through the same reader thread pipeline
+ * as file scans, so pipelines like journalctl | hypergrep never spill to a temp file or pay a second
+ * read pass.
+ *
+ * fd: Open descriptor to read to exhaustion. Never seeked, so pipes and terminals both work.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * max_match_count: Stop reading the stream after requested number of matches found.
+ */
+int hyperscan_fd(
+    int fd,
+    hyperscanner_state_t* state,
+    hyperscanner_t* scanner,
+    unsigned long long max_match_count
+) {
+    int stream_fd = dup(fd);
+    if (stream_fd < 0) {
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    gzFile input_file = gzdopen(stream_fd, "rb");
+    if (input_file == Z_NULL) {
+        close(stream_fd);
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    // Grow the internal decode buffer, the default is far too small for block sized reads.
+    gzbuffer(input_file, 128 * 1024);
+
+    // Probe the stream type from the first decoded bytes. Unrecognized data passes through the gz
+    // wrapper raw, so a zstd stream surfaces its own magic here and can be routed to libzstd.
+    unsigned char magic[4];
+    int peek_length = gzread(input_file, magic, sizeof(magic));
+    if (peek_length < 0) {
+        gzclose(input_file);
+        return HYPERSCANNER_DECODE;
+    }
+
+    int ret;
+    if (peek_length == (int) sizeof(magic)
+            && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        zstd_fd_reader_t reader;
+        memset(&reader, 0, sizeof(reader));
+        reader.input_file = input_file;
+        reader.dstream = ZSTD_createDStream();
+        reader.in_capacity = ZSTD_DStreamInSize();
+        reader.in_buffer = malloc(reader.in_capacity);
+        if (!reader.dstream || !reader.in_buffer) {
+            ZSTD_freeDStream(reader.dstream);
+            free(reader.in_buffer);
+            gzclose(input_file);
+            return HYPERSCANNER_STATE_MEM;
+        }
+        ZSTD_initDStream(reader.dstream);
+        // Replay the probed magic as the first compressed bytes so the decoder sees the whole frame.
+        memcpy(reader.in_buffer, magic, sizeof(magic));
+        reader.input.src = reader.in_buffer;
+        reader.input.size = sizeof(magic);
+
+        ret = scan_pipeline(state, scanner, zstd_fd_fill, &reader, max_match_count);
+
+        ZSTD_freeDStream(reader.dstream);
+        free(reader.in_buffer);
+    } else {
+        fd_reader_t reader;
+        reader.input_file = input_file;
+        memcpy(reader.peek, magic, (size_t) peek_length);
+        reader.peek_length = (size_t) peek_length;
+
+        ret = scan_pipeline(state, scanner, fd_fill, &reader, max_match_count);
+    }
+
+    if (state->stats) {
+        // gzoffset() reports the compressed position, i.e. raw bytes pulled from the stream.
+        state->stats->bytes_read += (unsigned long long) gzoffset(input_file);
+    }
+    gzclose(input_file);
+    return ret;
+}
+
+/*
+ * Memory map an entire file read only for block scanning.
+ *
+ * file_name: Location of a local uncompressed file.
+ * data: Location to store the mapped region. Left NULL for empty files.
+ * size: Location to store the size of the mapped region.
+ */
+static int map_input_file(const char* file_name, const char** data, size_t* size) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0) {
+        // File could not be opened for reading due to permissions, or bad file type.
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    size_t file_size = (size_t) file_stat.st_size;
+    if (file_size == 0) {
+        // Nothing to scan.
+        close(fd);
+        return 0;
+    }
+    const char* mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) {
+        return HYPERSCANNER_MMAP;
+    }
+    // Advise the kernel about the access pattern to maximize readahead while pages stream through once.
+    madvise((void*) mapped, file_size, MADV_SEQUENTIAL);
+    *data = mapped;
+    *size = file_size;
+    return 0;
+}
+
+/*
+ * Scan one newline terminated block of lines, maintaining line number accounting across calls.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * db: A compiled Hyperscan pattern database.
+ * scratch: A per-thread Hyperscan scratch space allocated for this database.
+ * block: Start of the block. Must begin at a line boundary.
+ * block_length: Size of the block.
+ */
+static int scan_block(
+    hyperscanner_state_t* state,
+    hs_database_t* db,
+    hs_scratch_t* scratch,
+    const char* block,
+    size_t block_length
+) {
+    state->block = block;
+    state->block_length = block_length;
+    state->block_cursor = 0;
+    state->block_line_start = 0;
+    state->block_line_end = 0;
+    if (state->after_pending > 0) {
+        // After context owed by a match in an earlier block resumes at the start of this one.
+        state->after_cursor = 0;
+        state->after_line = state->line_number;
+    }
+    if (state->invert) {
+        state->invert_cursor = 0;
+        state->invert_line = state->line_number;
+    }
+    if (state->counters) {
+        // Opt-in line length histogram, walked up front so the match callbacks stay untouched.
+        // Blocks are split at newline boundaries, so every segment here is one complete line.
+        const char* cursor = block;
+        const char* end = block + block_length;
+        const char* newline;
+        while ((newline = memchr(cursor, '\n', end - cursor)) != NULL) {
+            size_t line_length = (size_t) (newline - cursor) + 1;
+            unsigned int bucket = 0;
+            while ((line_length >>= 1) != 0 && bucket < HYPERSCANNER_COUNTER_LENGTH_BUCKETS - 1) {
+                bucket++;
+            }
+            state->counters->line_lengths[bucket]++;
+            cursor = newline + 1;
+        }
+    }
+    // Select the most specialized callback variant for the scan mode once per block, so the
+    // per match hot path only carries the feature checks the mode actually requires.
+    match_event_handler block_callback;
+    if (state->invert) {
+        block_callback = hs_invert_callback;
+    } else if (state->counts || state->counters || state->before_context || state->after_context) {
+        block_callback = hs_block_callback;
+    } else if (state->dedup_ids || state->line_dedup) {
+        block_callback = hs_block_dedup_callback;
+    } else {
+        block_callback = hs_block_plain_callback;
+    }
+    hs_error_t scan_ret;
+    if (state->stats) {
+        // Callback time is tracked separately and removed so scan time reflects the engine alone.
+        unsigned long long callback_before = state->stats->callback_ns;
+        unsigned long long begin = monotonic_ns();
+        scan_ret = hs_scan(db, block, (unsigned int) block_length, 0, scratch, block_callback, state);
+        state->stats->scan_ns += monotonic_ns() - begin - (state->stats->callback_ns - callback_before);
+        state->stats->bytes_scanned += block_length;
+    } else {
+        scan_ret = hs_scan(db, block, (unsigned int) block_length, 0, scratch, block_callback, state);
+    }
+    if (scan_ret == HS_SCAN_TERMINATED) {
+        // The callback halted the scan: intentionally when the match cap was reached, otherwise
+        // because the arena could not grow. Line accounting stops here, outer loops break on the cap.
+        if (state->max_match_count > 0 && state->match_count >= state->max_match_count) {
+            return 0;
+        }
+        return HYPERSCANNER_STATE_MEM;
+    }
+    if (scan_ret != HS_SUCCESS) {
+        fprintf(stderr, "ERROR: Unable to scan buffer. Exiting.\n");
+        return HYPERSCANNER_SCAN;
+    }
+
+    // Account for the newlines after the final match so line numbers stay correct into the next block.
+    const char* cursor = block + state->block_cursor;
+    const char* block_end = block + block_length;
+    const char* newline;
+    while ((newline = memchr(cursor, '\n', block_end - cursor)) != NULL) {
+        state->line_number++;
+        cursor = newline + 1;
+    }
+
+    // Report the clean lines after the final excluded line of the block in inverted mode.
+    if (state->invert && emit_invert_lines(state, block_length) != 0) {
+        if (state->max_match_count > 0 && state->match_count >= state->max_match_count) {
+            return 0;
+        }
+        return HYPERSCANNER_STATE_MEM;
+    }
+
+    // Emit any owed after context within this block, then refresh the ring of trailing lines so
+    // before context for matches early in the next block can reach back across the boundary.
+    if (!state->counts && (state->before_context || state->after_context)) {
+        int context_ret = flush_after_context(state, ULLONG_MAX);
+        if (context_ret == 0 && state->before_context > 0) {
+            context_ret = context_ring_update(state, block, block_length);
+        }
+        if (context_ret != 0) {
+            return context_ret;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Scan a memory region block by block, trimming every block to newline boundaries.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * db: A compiled Hyperscan pattern database.
+ * scratch: A per-thread Hyperscan scratch space allocated for this database.
+ * data: Start of the region to scan. Must begin at a line boundary. The caller sets block_base on
+ *     the state to the absolute offset of the region before calling, so byte offsets stay absolute
+ *     for ranged scans and parallel segments.
+ * size: Size of the region to scan.
+ * max_match_count: Stop scanning the region after requested number of matches found.
+ */
+static int scan_memory_blocks(
+    hyperscanner_state_t* state,
+    hs_database_t* db,
+    hs_scratch_t* scratch,
+    const char* data,
+    size_t size,
+    unsigned long long max_match_count
+) {
+    int ret = 0;
+
+    unsigned long long region_base = state->block_base;
+    size_t offset = 0;
+    while (offset < size) {
+        size_t block_length = size - offset;
+        if (block_length > HYPERSCANNER_BLOCK_SIZE) {
+            // Trim the block to the last full line so patterns never straddle a scan boundary.
+            const char* last_newline = memrchr(data + offset, '\n', HYPERSCANNER_BLOCK_SIZE);
+            if (last_newline) {
+                block_length = last_newline - (data + offset) + 1;
+            } else {
+                // A single line is larger than the block size, extend through its terminating newline.
+                const char* next_newline = memchr(data + offset + HYPERSCANNER_BLOCK_SIZE, '\n', size - offset - HYPERSCANNER_BLOCK_SIZE);
+                block_length = next_newline ? (size_t) (next_newline - (data + offset)) + 1 : size - offset;
+            }
+        }
+
+        state->block_base = region_base + offset;
+        ret = scan_block(state, db, scratch, data + offset, block_length);
+        if (ret != 0) {
+            break;
+        }
+        if (max_match_count > 0 && state->match_count >= max_match_count) {
+            break;
+        }
+        offset += block_length;
+    }
+    state->block = NULL;
+    return ret;
+}
+
+/*
+ * Scan an uncompressed file using Intel Hyperscan by memory mapping it and feeding large blocks directly.
+ *
+ * The kernel page cache is the only copy of the file data: blocks are trimmed to newline boundaries and
+ * passed straight to hs_scan(), with line numbers and bounds recovered from the match offsets. Only lines
+ * that actually matched are materialized into the shared arena for the result batches.
+ *
+ * file_name: Location of a local uncompressed file.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * db: A compiled Hyperscan pattern database.
+ * scratch: A per-thread Hyperscan scratch space allocated for this database.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan_mmap(
+    char* file_name,
+    hyperscanner_state_t* state,
+    hs_database_t* db,
+    hs_scratch_t* scratch,
+    unsigned long long max_match_count
+) {
+    const char* data = NULL;
+    size_t file_size = 0;
+    int ret = map_input_file(file_name, &data, &file_size);
+    if (ret != 0 || file_size == 0) {
+        return ret;
+    }
+    if (state->skip_binary && is_binary_data(data, file_size)) {
+        munmap((void*) data, file_size);
+        return HYPERSCANNER_BINARY;
+    }
+    if (state->stats) {
+        state->stats->bytes_read += file_size;
+    }
+
+    state->block_base = 0;
+    ret = scan_memory_blocks(state, db, scratch, data, file_size, max_match_count);
+
+    munmap((void*) data, file_size);
+    return ret;
+}
+
+/*
+ * State owned by a single parallel scan worker covering one newline aligned segment of a file.
+ *
+ * thread: Thread executing the segment scan.
+ * state: Per-worker scan state. Results are routed to the collector for in-order merging.
+ * collector: In-memory sink for the worker's results.
+ * db: The shared compiled pattern database. Not owned.
+ * scratch: Scratch space cloned from the handle prototype. Owned by the worker.
+ * segment: Start of the worker's segment within the mapped file.
+ * segment_length: Size of the worker's segment.
+ * max_match_count: Per-worker cap on matches, mirroring the global cap.
+ * ret: Return code from the worker's scan.
+ */
+typedef struct parallel_worker {
+    pthread_t thread;
+    hyperscanner_state_t state;
+    result_collector_t collector;
+    hs_database_t* db;
+    hs_scratch_t* scratch;
+    const char* segment;
+    size_t segment_length;
+    unsigned long long max_match_count;
+    int ret;
+} parallel_worker_t;
+
+/*
+ * Thread entry point scanning one newline aligned segment with the worker's own scratch clone.
+ *
+ * arg: Pointer to the worker owning the segment.
+ */
+static void* parallel_worker_main(void* arg) {
+    parallel_worker_t* worker = (parallel_worker_t*) arg;
+    worker->ret = scan_memory_blocks(
+        &worker->state,
+        worker->db,
+        worker->scratch,
+        worker->segment,
+        worker->segment_length,
+        worker->max_match_count
+    );
+    // Ensure trailing results reach the collector before segment totals are merged.
+    flush_results(&worker->state);
+    if (worker->collector.failed && worker->ret == 0) {
+        worker->ret = HYPERSCANNER_STATE_MEM;
+    }
+    return NULL;
+}
+
+/*
+ * Locate the starting offsets of gzip members within a mapped archive.
+ *
+ * Rotated logs are typically concatenations of gzip members, one per rotation flush. Candidate
+ * headers are located by their magic bytes and validated by decoding a small probe, since the
+ * magic can also appear inside compressed data. A false positive that survives the probe is still
+ * caught later when a member decode overruns its boundary, which falls back to the serial path.
+ *
+ * data: Start of the mapped archive. The leading member at offset 0 is always included.
+ * file_size: Size of the mapped archive.
+ * offsets: Location to store the member offset array. Released by the caller.
+ * count: Location to store how many members were found.
+ */
+static int gz_member_index(const char* data, size_t file_size, size_t** offsets, size_t* count) {
+    size_t capacity = 16;
+    size_t found = 0;
+    size_t* member_offsets = (size_t*) malloc(sizeof(size_t) * capacity);
+    if (!member_offsets) {
+        return HYPERSCANNER_STATE_MEM;
+    }
+    member_offsets[found++] = 0;
+
+    char probe[4096];
+    size_t position = 1;
+    while (position + 10 < file_size) {
+        const char* candidate = memchr(data + position, 0x1f, file_size - position - 10);
+        if (!candidate) {
+            break;
+        }
+        size_t offset = candidate - data;
+        const unsigned char* header = (const unsigned char*) candidate;
+        if (header[1] == 0x8b && header[2] == 0x08 && (header[3] & 0xe0) == 0) {
+            // Validate the candidate by decoding a short probe with a throwaway inflate stream.
+            z_stream stream;
+            memset(&stream, 0, sizeof(stream));
+            if (inflateInit2(&stream, 15 + 16) == Z_OK) {
+                size_t available = file_size - offset;
+                stream.next_in = (unsigned char*) candidate;
+                stream.avail_in = (unsigned int) (available > sizeof(probe) ? sizeof(probe) : available);
+                stream.next_out = (unsigned char*) probe;
+                stream.avail_out = sizeof(probe);
+                int probe_ret = inflate(&stream, Z_NO_FLUSH);
+                inflateEnd(&stream);
+                if (probe_ret == Z_OK || probe_ret == Z_STREAM_END) {
+                    if (found == capacity) {
+                        capacity *= 2;
+                        size_t* new_offsets = (size_t*) realloc(member_offsets, sizeof(size_t) * capacity);
+                        if (!new_offsets) {
+                            free(member_offsets);
+                            return HYPERSCANNER_STATE_MEM;
+                        }
+                        member_offsets = new_offsets;
+                    }
+                    member_offsets[found++] = offset;
+                }
+            }
+        }
+        position = offset + 1;
+    }
+    *offsets = member_offsets;
+    *count = found;
+    return 0;
+}
+
+/*
+ * State owned by a single worker decompressing and scanning a run of gzip members.
+ *
+ * thread: Thread executing the member decode and scan.
+ * state: Per-worker scan state. Results are routed to the collector for in-order merging.
+ * collector: In-memory sink for the worker's results.
+ * db: The shared compiled pattern database. Not owned.
+ * scratch: Scratch space cloned from the handle prototype. Owned by the worker.
+ * input: Start of the worker's compressed range within the mapped archive.
+ * input_length: Size of the worker's compressed range. Covers whole members only.
+ * max_match_count: Per-worker cap on matches, mirroring the global cap.
+ * line_count: Total lines decoded by the worker, for adjusting later workers' line numbers.
+ * byte_count: Total decoded bytes produced by the worker, for adjusting later workers' byte offsets.
+ * fallback: Set when the range did not decode as complete members, e.g. a false boundary,
+ *     requesting a serial rescan of the whole archive instead of surfacing an error.
+ * ret: Return code from the worker's decode and scan.
+ */
+typedef struct gz_member_worker {
+    pthread_t thread;
+    hyperscanner_state_t state;
+    result_collector_t collector;
+    hs_database_t* db;
+    hs_scratch_t* scratch;
+    const char* input;
+    size_t input_length;
+    unsigned long long max_match_count;
+    unsigned long long line_count;
+    unsigned long long byte_count;
+    int fallback;
+    int ret;
+} gz_member_worker_t;
+
+/*
+ * Thread entry point inflating one run of gzip members and scanning the decoded lines.
+ *
+ * Decoded bytes are scanned block by block up to their last complete line, with partial tails
+ * carried into the next block, mirroring the serial pipeline consumer. Members are assumed to
+ * start at line boundaries, which rotation flushes guarantee.
+ *
+ * arg: Pointer to the worker owning the member run.
+ */
+static void* gz_member_worker_main(void* arg) {
+    gz_member_worker_t* worker = (gz_member_worker_t*) arg;
+    char* carry = NULL;
+    size_t carry_length = 0;
+    size_t carry_capacity = 0;
+    int stream_open = 0;
+    int finished = 0;
+    // Offsets are relative to the worker's decoded range, replay shifts them by earlier run totals.
+    unsigned long long stream_base = 0;
+    unsigned long long carry_base = 0;
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+
+    char* decoded = malloc(HYPERSCANNER_BLOCK_SIZE);
+    if (!decoded) {
+        worker->ret = HYPERSCANNER_STATE_MEM;
+        goto done;
+    }
+    if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+        worker->ret = HYPERSCANNER_DECODE;
+        goto done;
+    }
+    stream_open = 1;
+    stream.next_in = (unsigned char*) worker->input;
+    stream.avail_in = (unsigned int) worker->input_length;
+
+    while (!finished && worker->ret == 0) {
+        stream.next_out = (unsigned char*) decoded;
+        stream.avail_out = HYPERSCANNER_BLOCK_SIZE;
+        while (stream.avail_out > 0) {
+            int inflate_ret = inflate(&stream, Z_NO_FLUSH);
+            if (inflate_ret == Z_STREAM_END) {
+                if (stream.avail_in == 0) {
+                    finished = 1;
+                    break;
+                }
+                // Another member follows within this worker's range, e.g. several small rotations.
+                if (inflateReset(&stream) != Z_OK) {
+                    worker->ret = HYPERSCANNER_DECODE;
+                    break;
+                }
+            } else if (inflate_ret != Z_OK || stream.avail_in == 0) {
+                // The range did not decode as complete members, e.g. a boundary candidate that was
+                // really compressed data. Request a serial rescan instead of surfacing an error.
+                worker->ret = HYPERSCANNER_DECODE;
+                worker->fallback = 1;
+                break;
+            }
+        }
+        if (worker->ret != 0) {
+            break;
+        }
+        size_t length = HYPERSCANNER_BLOCK_SIZE - stream.avail_out;
+        if (length == 0) {
+            break;
+        }
+
+        // Scan the decoded block up to its last complete line, carrying any partial tail.
+        const char* data = decoded;
+        size_t pos = 0;
+        if (carry_length > 0) {
+            const char* first_newline = memchr(data, '\n', length);
+            size_t joined = first_newline ? (size_t) (first_newline - data) + 1 : length;
+            worker->ret = carry_append(&carry, &carry_length, &carry_capacity, data, joined);
+            if (worker->ret == 0 && first_newline) {
+                worker->state.block_base = carry_base;
+                worker->ret = scan_block(&worker->state, worker->db, worker->scratch, carry, carry_length);
+                carry_length = 0;
+            }
+            pos = joined;
+        }
+        if (worker->ret == 0 && pos < length) {
+            const char* last_newline = memrchr(data + pos, '\n', length - pos);
+            if (last_newline) {
+                size_t scan_length = (size_t) (last_newline - (data + pos)) + 1;
+                worker->state.block_base = stream_base + pos;
+                worker->ret = scan_block(&worker->state, worker->db, worker->scratch, data + pos, scan_length);
+                pos += scan_length;
+            }
+            if (worker->ret == 0 && pos < length) {
+                carry_base = stream_base + pos;
+                worker->ret = carry_append(&carry, &carry_length, &carry_capacity, data + pos, length - pos);
+            }
+        }
+        stream_base += length;
+        if (worker->max_match_count > 0 && worker->state.match_count >= worker->max_match_count) {
+            break;
+        }
+    }
+    if (worker->ret == 0 && finished && carry_length > 0) {
+        // The range does not end with a newline, scan the remainder as the final line.
+        worker->state.block_base = carry_base;
+        worker->ret = scan_block(&worker->state, worker->db, worker->scratch, carry, carry_length);
+        if (worker->ret == 0) {
+            // The trailing line has no newline to count, include it in the totals manually.
+            worker->state.line_number++;
+        }
+    }
+
+done:
+    if (stream_open) {
+        inflateEnd(&stream);
+    }
+    free(carry);
+    free(decoded);
+    worker->line_count = worker->state.line_number;
+    worker->byte_count = stream_base;
+    // Ensure trailing results reach the collector before member totals are merged.
+    flush_results(&worker->state);
+    if (worker->collector.failed && worker->ret == 0) {
+        worker->ret = HYPERSCANNER_STATE_MEM;
+    }
+    return NULL;
+}
+
+/*
+ * Scan a multi-member gzip archive by decompressing runs of members on parallel workers.
+ *
+ * The archive is indexed for member boundaries pigz style, contiguous runs of members are inflated
+ * and scanned concurrently, and the collected results are replayed in archive order with line
+ * numbers adjusted by the totals of every preceding run. Members are assumed to start at line
+ * boundaries, which rotation flushes guarantee.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local gzip archive.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings per worker.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop after requested number of matches found. Applied per worker during scanning,
+ *     and enforced globally while merging, so a few extra matches may be scanned but never reported.
+ * thread_count: How many worker threads to decode and scan with. Clamped to the member count.
+ *
+ * Returns -1 when the archive should be rescanned on the serial path instead: a single member
+ * archive, or a member run that did not decode cleanly. Nothing is emitted in that case.
+ */
+static int hyperscan_gz_parallel(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    int thread_count
+) {
+    const char* data = NULL;
+    size_t file_size = 0;
+    int ret = map_input_file(file_name, &data, &file_size);
+    if (ret != 0) {
+        return ret;
+    }
+    if (file_size == 0) {
+        munmap((void*) data, file_size);
+        return -1;
+    }
+
+    size_t* offsets = NULL;
+    size_t member_count = 0;
+    ret = gz_member_index(data, file_size, &offsets, &member_count);
+    if (ret != 0 || member_count < 2) {
+        // A single member archive decodes strictly serially, nothing to parallelize.
+        free(offsets);
+        munmap((void*) data, file_size);
+        return ret != 0 ? ret : -1;
+    }
+
+    int workers_count = thread_count < (int) member_count ? thread_count : (int) member_count;
+    gz_member_worker_t* workers = (gz_member_worker_t*) calloc(workers_count, sizeof(gz_member_worker_t));
+    if (!workers) {
+        free(offsets);
+        munmap((void*) data, file_size);
+        return HYPERSCANNER_STATE_MEM;
+    }
+
+    // Split the member list into contiguous runs so each worker's output stays in archive order.
+    int started = 0;
+    for (int index = 0; index < workers_count && ret == 0; index++) {
+        size_t first_member = member_count * index / workers_count;
+        size_t last_member = member_count * (index + 1) / workers_count;
+        size_t range_start = offsets[first_member];
+        size_t range_end = last_member < member_count ? offsets[last_member] : file_size;
+
+        gz_member_worker_t* worker = &workers[index];
+        worker->db = scanner->db;
+        worker->input = data + range_start;
+        worker->input_length = range_end - range_start;
+        worker->max_match_count = max_match_count;
+        worker->state.result_index = -1;
+        worker->state.max_match_count = max_match_count;
+        worker->state.max_result_index = buffer_count - 1;
+        // Dedup state is per line, so folding within each member matches the serial output.
+        worker->state.line_dedup = scanner->line_dedup;
+        worker->state.collector = &worker->collector;
+        worker->state.results = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * buffer_count);
+        worker->state.arena_size = (size_t) buffer_size * 2;
+        worker->state.arena = malloc(worker->state.arena_size);
+        if (scanner->single_match) {
+            worker->state.dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        }
+        if (!worker->state.results || !worker->state.arena || (scanner->single_match && !worker->state.dedup_ids)) {
+            ret = HYPERSCANNER_STATE_MEM;
+            break;
+        }
+        ret = scratch_pool_acquire(scanner, &worker->scratch);
+        if (ret != 0) {
+            break;
+        }
+        if (pthread_create(&worker->thread, NULL, gz_member_worker_main, worker) != 0) {
+            scratch_pool_release(scanner, worker->scratch);
+            worker->scratch = NULL;
+            ret = HYPERSCANNER_STATE_MEM;
+            break;
+        }
+        started++;
+    }
+
+    int fallback = 0;
+    for (int index = 0; index < started; index++) {
+        pthread_join(workers[index].thread, NULL);
+        if (workers[index].fallback) {
+            fallback = 1;
+        } else if (ret == 0 && workers[index].ret != 0) {
+            ret = workers[index].ret;
+        }
+    }
+
+    // Replay the collected results in archive order through the caller's batching, adjusting the
+    // per-run line numbers by the total line count of every preceding run. Nothing was emitted
+    // before this point, so falling back to a serial rescan never duplicates results.
+    if (ret == 0 && !fallback) {
+        hyperscanner_result_t* batch = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * buffer_count);
+        if (!batch) {
+            ret = HYPERSCANNER_STATE_MEM;
+        } else {
+            unsigned long long line_base = 0;
+            unsigned long long byte_base = 0;
+            unsigned long long emitted = 0;
+            int batch_index = 0;
+            for (int index = 0; index < started; index++) {
+                gz_member_worker_t* worker = &workers[index];
+                for (size_t result_index = 0; result_index < worker->collector.count; result_index++) {
+                    if (max_match_count > 0 && emitted >= max_match_count) {
+                        break;
+                    }
+                    batch[batch_index] = worker->collector.results[result_index];
+                    batch[batch_index].line = worker->collector.lines + worker->collector.line_offsets[result_index];
+                    batch[batch_index].line_number += line_base;
+                    batch[batch_index].byte_offset += byte_base;
+                    batch_index++;
+                    emitted++;
+                    if (batch_index == buffer_count) {
+                        on_event(batch, batch_index);
+                        batch_index = 0;
+                    }
+                }
+                line_base += worker->line_count;
+                byte_base += worker->byte_count;
+            }
+            if (batch_index > 0) {
+                on_event(batch, batch_index);
+            }
+            free(batch);
+        }
+    }
+
+    for (int index = 0; index < workers_count; index++) {
+        gz_member_worker_t* worker = &workers[index];
+        scratch_pool_release(scanner, worker->scratch);
+        free(worker->state.dedup_ids);
+        free(worker->state.arena);
+        free(worker->state.results);
+        free(worker->collector.results);
+        free(worker->collector.line_offsets);
+        free(worker->collector.lines);
+    }
+    free(workers);
+    free(offsets);
+    munmap((void*) data, file_size);
+    if (ret == 0 && fallback) {
+        return -1;
+    }
+    return ret;
+}
+
+/*
+ * Attach line and result buffers to a per scan state, reusing the handle's recycled buffers when possible.
+ *
+ * The arena starts at a small size class instead of a full read buffer and grows geometrically on
+ * demand inside arena_reserve(), so scans of typical short log lines never commit large mostly idle
+ * buffers. Grown buffers are returned to the handle by release_scan_buffers() and reused by the next
+ * scan, amortizing the growth across every file scanned with a persistent handle.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * max_results: How many result slots the scan batches before flushing to the caller.
+ */
+static int acquire_scan_buffers(hyperscanner_state_t* state, hyperscanner_t* scanner, int max_results) {
+    if (scanner->results_cache && scanner->results_cache_count < max_results) {
+        // The recycled array is from a scan with a smaller batch size, release it and start over.
+        free(scanner->results_cache);
+        scanner->results_cache = NULL;
+        scanner->results_cache_count = 0;
+    }
+    if (scanner->results_cache) {
+        state->results = scanner->results_cache;
+        scanner->results_cache = NULL;
+        scanner->results_cache_count = 0;
+    } else {
+        state->results = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * max_results);
+    }
+    if (scanner->arena_cache) {
+        state->arena = scanner->arena_cache;
+        state->arena_size = scanner->arena_cache_size;
+        scanner->arena_cache = NULL;
+        scanner->arena_cache_size = 0;
+    } else {
+        state->arena_size = HYPERSCANNER_ARENA_MIN_SIZE;
+        state->arena = malloc(state->arena_size);
+    }
+    if (!state->results || !state->arena) {
+        return HYPERSCANNER_COMPILE_MEM;
+    }
+    return 0;
+}
+
+/*
+ * Return a scan's line and result buffers to the handle for reuse by the next scan.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ */
+static void release_scan_buffers(hyperscanner_state_t* state, hyperscanner_t* scanner) {
+    if (!scanner->arena_cache && state->arena) {
+        scanner->arena_cache = state->arena;
+        scanner->arena_cache_size = state->arena_size;
+    } else {
+        free(state->arena);
+    }
+    state->arena = NULL;
+    if (!scanner->results_cache && state->results) {
+        scanner->results_cache = state->results;
+        scanner->results_cache_count = state->max_result_index + 1;
+    } else {
+        free(state->results);
+    }
+    state->results = NULL;
+}
+
+/*
+ * Attach the context configuration from a handle to a per scan state, allocating the ring and scratch.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * scanner: Handle previously initialized by hyperscanner_create().
+ */
+static int setup_context(hyperscanner_state_t* state, hyperscanner_t* scanner) {
+    state->before_context = scanner->before_context;
+    state->after_context = scanner->after_context;
+    if (state->before_context > 0) {
+        state->context_ring = (context_line_t*) calloc(state->before_context, sizeof(context_line_t));
+        state->before_offsets = (size_t*) malloc(sizeof(size_t) * state->before_context);
+        if (!state->context_ring || !state->before_offsets) {
+            return HYPERSCANNER_STATE_MEM;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Release the before context ring and scratch owned by a per scan state.
+ *
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ */
+static void release_context(hyperscanner_state_t* state) {
+    if (state->context_ring) {
+        for (unsigned int index = 0; index < state->before_context; index++) {
+            free(state->context_ring[index].data);
+        }
+        free(state->context_ring);
+    }
+    free(state->before_offsets);
+}
+
+/*
+ * Route a single file scan to the fastest path for its detected type.
+ *
+ * Uncompressed files skip the gzip wrapper for direct block scanning, and zstd files stream
+ * through libzstd directly instead of the gz* emulation layer.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file.
+ * state: Stateful information used to track additional details from Intel Hyperscan during callbacks.
+ * buffer_size: How large of a char buffer to use while reading compressed files line by line.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+static int route_scan(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hyperscanner_state_t* state,
+    const int buffer_size,
+    unsigned long long max_match_count
+) {
+    if (strcmp(file_name, "-") == 0) {
+        // Grep style stdin marker, scan the descriptor as an unseekable stream.
+        return hyperscan_fd(STDIN_FILENO, state, scanner, max_match_count);
+    }
+    struct stat file_stat;
+    if (stat(file_name, &file_stat) == 0 && !S_ISREG(file_stat.st_mode)) {
+        // FIFOs, devices, and similar special files cannot be mapped, and sniffing their magic
+        // would consume bytes, so scan them as streams like stdin, e.g. hypergrep <(zcat huge.gz).
+        int stream_fd = open(file_name, O_RDONLY);
+        if (stream_fd < 0) {
+            return HYPERSCANNER_GZ_OPEN;
+        }
+        // hyperscan_fd() duplicates the descriptor, so the local one is always closed here.
+        int stream_ret = hyperscan_fd(stream_fd, state, scanner, max_match_count);
+        close(stream_fd);
+        return stream_ret;
+    }
+    hyperscanner_file_type_t file_type = detect_file_type(file_name);
+    if (file_type == HYPERSCANNER_FILE_PLAIN) {
+        return hyperscan_mmap(file_name, state, scanner->db, scanner->scratch, max_match_count);
+    }
+    if (file_type == HYPERSCANNER_FILE_ZSTD) {
+        return hyperscan_zstd(file_name, state, scanner, max_match_count);
+    }
+    return hyperscan_gz(file_name, state, scanner, buffer_size, max_match_count);
+}
+
+/*
+ * Shared implementation for single file scans, with optional performance counters.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file that can be read line by line.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ * stats: Optional counters filled during the scan. NULL disables all instrumentation.
+ */
+static int scan_file_internal(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    hyperscanner_stats_t* stats
+) {
+    if (max_match_count > 0 && max_match_count < buffer_count) {
+        // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
+        buffer_count = max_match_count;
+    }
+    int ret = 0;
+
+    // Initialize the per-file state. If any part cannot be created, skip processing.
+    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+    if (!state) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    memset(state, 0, sizeof(hyperscanner_state_t));
+    state->callback = on_event;
+    state->max_match_count = max_match_count;
+    state->stats = stats;
+    if (stats && scanner->counters) {
+        // Distribution counters live inside the caller's stats block, already reset with it.
+        state->counters = &stats->counters;
+    }
+    state->skip_binary = scanner->skip_binary;
+    state->invert = scanner->invert;
+    state->line_dedup = scanner->line_dedup;
+
+    state->result_index = -1;
+    state->max_result_index = buffer_count - 1;
+    int max_results = state->max_result_index + 1;
+
+    // Share one arena across all results instead of a full line buffer per slot. The arena and result
+    // slots are pooled on the handle, starting at a small size class and growing with the workload.
+    ret = acquire_scan_buffers(state, scanner, max_results);
+    if (ret != 0) {
+        goto cleanup;
+    }
+    if (scanner->single_match) {
+        // Track which pattern ids already reported for the current line to enforce single match semantics.
+        state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        if (!state->dedup_ids) {
+            ret = HYPERSCANNER_COMPILE_MEM;
+            goto cleanup;
+        }
+    }
+
+    ret = setup_context(state, scanner);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = route_scan(scanner, file_name, state, buffer_size, max_match_count);
+
+    // Ensure the buffer is sent if there are any remaining results.
+    flush_results(state);
+    if (stats) {
+        stats->lines_scanned = state->line_number;
+        stats->matches = state->match_count;
+    }
+
+cleanup:
+    // Ensure all buffers are reclaimed before exiting in case usage is multi-threaded.
+    if (state) {
+        release_context(state);
+        free(state->dedup_ids);
+        release_scan_buffers(state, scanner);
+        free(state);
+    }
+    return ret;
+}
+
+/*
+ * Scan a single file using a persistent scanner handle, reusing the compiled database and scratch space.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file that can be read line by line.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscanner_scan_file(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    return scan_file_internal(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count, NULL);
+}
+
+/*
+ * Scan a single file while collecting per stage performance counters.
+ *
+ * Identical to hyperscanner_scan_file() with stats reset and filled across the scan. Collection adds
+ * two clock reads per block and per callback batch, negligible against block sized scans.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file that can be read line by line.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ * stats: Caller provided counters filled during the scan.
+ */
+int hyperscanner_scan_file_stats(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    hyperscanner_stats_t* stats
+) {
+    memset(stats, 0, sizeof(hyperscanner_stats_t));
+    return scan_file_internal(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count, stats);
+}
+
+/*
+ * Scan a single file delivering results through caller provided shared memory.
+ *
+ * Lines are materialized directly into the caller's arena and batch metadata is written into the
+ * caller's slot table as arena offsets, so only the batch count crosses the callback boundary.
+ * Callers slice the arena lazily instead of copying every line out of pointer based batches,
+ * which keeps match dense scans from turning allocation bound in managed runtimes.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file that can be read line by line.
+ * on_event: Function signalled with only the filled slot count after each batch.
+ *     The slots and arena contents are only valid for the duration of the signal.
+ * arena: Caller provided buffer that receives the NUL terminated result lines.
+ * arena_size: Total capacity of arena in bytes. Must hold the longest expected line plus one,
+ *     a line that cannot fit fails the scan with HYPERSCANNER_STATE_MEM.
+ * slots: Caller provided table receiving one record per result in the current batch.
+ * slot_count: How many entries are in slots, and therefore the result batch size.
+ * buffer_size: How large of a char buffer to use while reading compressed files line by line.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscanner_scan_file_shared(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_shared_event on_event,
+    char* arena,
+    unsigned long long arena_size,
+    hyperscanner_shared_result_t* slots,
+    int slot_count,
+    const int buffer_size,
+    unsigned long long max_match_count
+) {
+    if (max_match_count > 0 && max_match_count < slot_count) {
+        // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
+        slot_count = max_match_count;
+    }
+    int ret = 0;
+
+    // Initialize the per-file state around the caller's buffers. If any part cannot be created, skip processing.
+    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+    if (!state) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    memset(state, 0, sizeof(hyperscanner_state_t));
+    state->max_match_count = max_match_count;
+    state->skip_binary = scanner->skip_binary;
+    state->invert = scanner->invert;
+    state->line_dedup = scanner->line_dedup;
+    state->shared_slots = slots;
+    state->shared_callback = on_event;
+    state->arena = arena;
+    state->arena_size = (size_t) arena_size;
+    state->arena_fixed = 1;
+
+    state->result_index = -1;
+    state->max_result_index = slot_count - 1;
+    state->results = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * slot_count);
+    if (!state->results) {
+        ret = HYPERSCANNER_COMPILE_MEM;
+        goto cleanup;
+    }
+    if (scanner->single_match) {
+        // Track which pattern ids already reported for the current line to enforce single match semantics.
+        state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        if (!state->dedup_ids) {
+            ret = HYPERSCANNER_COMPILE_MEM;
+            goto cleanup;
+        }
+    }
+    ret = setup_context(state, scanner);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = route_scan(scanner, file_name, state, buffer_size, max_match_count);
+
+    // Ensure the buffer is sent if there are any remaining results.
+    flush_results(state);
+
+cleanup:
+    // Ensure all internal buffers are reclaimed, the arena and slots remain owned by the caller.
+    if (state) {
+        release_context(state);
+        free(state->dedup_ids);
+        free(state->results);
+        free(state);
+    }
+    return ret;
+}
+
+/*
+ * Scan one byte range of an uncompressed file, so huge files can be sharded across workers.
+ *
+ * The range covers every line that begins in [start_offset, end_offset): the start skips any
+ * partial line owned by the previous range, and the end extends through the final owned line's
+ * newline. Adjacent ranges therefore partition a file exactly with no duplicated or dropped lines.
+ * Compressed files cannot be ranged, decoded offsets require reading from the start anyway.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local uncompressed file.
+ * start_offset: First byte of the range. Lines beginning before this offset belong to the previous range.
+ * end_offset: One past the last byte of the range. Clamped to the file size.
+ * line_number_hint: How many lines precede start_offset, so results report absolute line numbers.
+ *     Pass 0 if relative line numbers within the range are acceptable.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading the range after requested number of matches found.
+ */
+int hyperscanner_scan_range(
+    hyperscanner_t* scanner,
+    char* file_name,
+    unsigned long long start_offset,
+    unsigned long long end_offset,
+    unsigned long long line_number_hint,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    struct stat range_stat;
+    if (stat(file_name, &range_stat) != 0 || !S_ISREG(range_stat.st_mode)
+        || detect_file_type(file_name) != HYPERSCANNER_FILE_PLAIN) {
+        // Ranged scans need random access to decoded bytes, which compressed files and
+        // unseekable special files cannot provide.
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    if (max_match_count > 0 && max_match_count < buffer_count) {
+        // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
+        buffer_count = max_match_count;
+    }
+    int ret = 0;
+    const char* data = NULL;
+    size_t file_size = 0;
+
+    // Initialize the per-range state. If any part cannot be created, skip processing.
+    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+    if (!state) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    memset(state, 0, sizeof(hyperscanner_state_t));
+    state->callback = on_event;
+    state->max_match_count = max_match_count;
+    state->line_number = line_number_hint;
+    state->skip_binary = scanner->skip_binary;
+    state->invert = scanner->invert;
+    state->line_dedup = scanner->line_dedup;
+
+    state->result_index = -1;
+    state->max_result_index = buffer_count - 1;
+    int max_results = state->max_result_index + 1;
+    ret = acquire_scan_buffers(state, scanner, max_results);
+    if (ret != 0) {
+        goto cleanup;
+    }
+    if (scanner->single_match) {
+        // Track which pattern ids already reported for the current line to enforce single match semantics.
+        state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        if (!state->dedup_ids) {
+            ret = HYPERSCANNER_COMPILE_MEM;
+            goto cleanup;
+        }
+    }
+
+    ret = setup_context(state, scanner);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    ret = map_input_file(file_name, &data, &file_size);
+    if (ret != 0 || file_size == 0 || start_offset >= file_size) {
+        goto cleanup;
+    }
+    if (state->skip_binary && is_binary_data(data, file_size)) {
+        ret = HYPERSCANNER_BINARY;
+        goto cleanup;
+    }
+    if (end_offset > file_size) {
+        end_offset = file_size;
+    }
+
+    // Trim both edges to line boundaries. A boundary exactly on a newline leaves the offset as is,
+    // so the same arithmetic on adjacent ranges always agrees on line ownership.
+    size_t range_start = 0;
+    if (start_offset > 0) {
+        const char* newline = memchr(data + start_offset - 1, '\n', file_size - (start_offset - 1));
+        range_start = newline ? (size_t) (newline - data) + 1 : file_size;
+    }
+    size_t range_end = file_size;
+    if (end_offset < file_size) {
+        const char* newline = memchr(data + end_offset - 1, '\n', file_size - (end_offset - 1));
+        range_end = newline ? (size_t) (newline - data) + 1 : file_size;
+    }
+    if (range_start < range_end) {
+        state->block_base = range_start;
+        ret = scan_memory_blocks(state, scanner->db, scanner->scratch, data + range_start, range_end - range_start, max_match_count);
+    }
+
+    // Ensure the buffer is sent if there are any remaining results.
+    flush_results(state);
+
+cleanup:
+    if (data) {
+        munmap((void*) data, file_size);
+    }
+    // Ensure all buffers are reclaimed before exiting in case usage is multi-threaded.
+    if (state) {
+        release_context(state);
+        free(state->dedup_ids);
+        release_scan_buffers(state, scanner);
+        free(state);
+    }
+    return ret;
+}
+
+/*
+ * Scan a list of files with one persistent handle, reusing every buffer across the whole batch.
+ *
+ * Amortizes database compilation, state allocation, and caller crossings over the full file list:
+ * results are tagged with the index of the file that produced them so one callback stream can
+ * serve the entire batch. Scanning continues past per file failures, and the first failure code
+ * is returned after every file has been attempted.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_names: Locations of local files that can be read line by line.
+ * file_count: How many entries are in file_names.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading each file after requested number of matches found. Applied per file.
+ */
+int hyperscanner_scan_files(
+    hyperscanner_t* scanner,
+    char** file_names,
+    const unsigned int file_count,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    if (max_match_count > 0 && max_match_count < buffer_count) {
+        // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
+        buffer_count = max_match_count;
+    }
+    int ret = 0;
+
+    // Initialize state shared by every file in the batch. If any part cannot be created, skip processing.
+    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+    if (!state) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    memset(state, 0, sizeof(hyperscanner_state_t));
+    state->callback = on_event;
+    state->max_match_count = max_match_count;
+    state->skip_binary = scanner->skip_binary;
+    state->invert = scanner->invert;
+    state->line_dedup = scanner->line_dedup;
+
+    state->result_index = -1;
+    state->max_result_index = buffer_count - 1;
+    int max_results = state->max_result_index + 1;
+    ret = acquire_scan_buffers(state, scanner, max_results);
+    if (ret != 0) {
+        goto cleanup;
+    }
+    if (scanner->single_match) {
+        state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        if (!state->dedup_ids) {
+            ret = HYPERSCANNER_COMPILE_MEM;
+            goto cleanup;
+        }
+    }
+
+    ret = setup_context(state, scanner);
+    if (ret != 0) {
+        goto cleanup;
+    }
+
+    for (unsigned int index = 0; index < file_count; index++) {
+        // Reset the per file accounting while keeping every allocation for the next file.
+        state->match_count = 0;
+        state->line_number = 0;
+        state->dedup_id_count = 0;
+        state->dedup_line = 0;
+        state->dedup_line_done = 0;
+        state->file_index = index;
+        state->reported_through = 0;
+        state->after_pending = 0;
+        if (state->context_ring) {
+            for (unsigned int entry = 0; entry < state->before_context; entry++) {
+                state->context_ring[entry].used = 0;
+            }
+        }
+        int file_ret = route_scan(scanner, file_names[index], state, buffer_size, max_match_count);
+        // Flush before rewinding the arena so results never reference memory reused by the next file.
+        flush_results(state);
+        state->arena_offset = 0;
+        if (file_ret != 0 && ret == 0) {
+            ret = file_ret;
+        }
+    }
+
+cleanup:
+    if (state) {
+        release_context(state);
+        free(state->dedup_ids);
+        release_scan_buffers(state, scanner);
+        free(state);
+    }
+    return ret;
+}
+
+/*
+ * Recursively collect every regular file under a directory into a growable path list.
+ *
+ * Entries within each directory are visited in alphabetical order so results are deterministic
+ * regardless of filesystem layout. Symbolic links are skipped to avoid cycles, and entries that
+ * vanish mid walk, common on live log trees, are skipped rather than failing the scan.
+ *
+ * root: Directory to walk. Must be an accessible directory.
+ * files: Location of the path list, grown geometrically as files are found. Entries and list are
+ *     released by the caller.
+ * count: How many paths are in the list.
+ * capacity: Total capacity of the list.
+ */
+static int tree_collect(const char* root, char*** files, unsigned int* count, unsigned int* capacity) {
+    struct dirent** entries = NULL;
+    int entry_count = scandir(root, &entries, NULL, alphasort);
+    if (entry_count < 0) {
+        return HYPERSCANNER_GZ_OPEN;
+    }
+    int ret = 0;
+    for (int index = 0; index < entry_count; index++) {
+        const char* name = entries[index]->d_name;
+        if (ret == 0 && strcmp(name, ".") != 0 && strcmp(name, "..") != 0) {
+            char path[PATH_MAX];
+            struct stat info;
+            if (snprintf(path, sizeof(path), "%s/%s", root, name) < (int) sizeof(path) && lstat(path, &info) == 0) {
+                if (S_ISDIR(info.st_mode)) {
+                    ret = tree_collect(path, files, count, capacity);
+                    if (ret == HYPERSCANNER_GZ_OPEN) {
+                        // Unreadable subdirectories are skipped like vanished entries, only the
+                        // root itself must be readable for the walk to proceed.
+                        ret = 0;
+                    }
+                } else if (S_ISREG(info.st_mode)) {
+                    if (*count == *capacity) {
+                        unsigned int new_capacity = *capacity ? *capacity * 2 : 256;
+                        char** new_files = (char**) realloc(*files, sizeof(char*) * new_capacity);
+                        if (!new_files) {
+                            ret = HYPERSCANNER_STATE_MEM;
+                        } else {
+                            *files = new_files;
+                            *capacity = new_capacity;
+                        }
+                    }
+                    if (ret == 0) {
+                        (*files)[*count] = strdup(path);
+                        if (!(*files)[*count]) {
+                            ret = HYPERSCANNER_STATE_MEM;
+                        } else {
+                            (*count)++;
+                        }
+                    }
+                }
+            }
+        }
+        free(entries[index]);
+    }
+    free(entries);
+    return ret;
+}
+
+/*
+ * Hint the kernel to begin reading a file into the page cache before the scan reaches it.
+ *
+ * file_name: Location of an upcoming file in the tree scan order.
+ */
+static void tree_readahead(const char* file_name) {
+    int fd = open(file_name, O_RDONLY);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+        close(fd);
+    }
+}
+
+/*
+ * Recursively scan every regular file under a directory with one persistent handle.
+ *
+ * Walks the tree natively instead of dispatching per file from the caller, so small file workloads
+ * are bounded by I/O rather than per call crossings. Upcoming files are hinted to the kernel with
+ * posix_fadvise() so their pages load while earlier files scan. Each file is announced through
+ * on_file before its results are emitted, and results are tagged with the file's index, so one
+ * callback stream serves the entire tree. Scanning continues past per file failures, and the first
+ * failure code is returned after every file has been attempted.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * root: Directory to walk recursively. Files are visited in alphabetical order per directory.
+ * on_file: Function to call with each file's index and path before its results are emitted.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading each file after requested number of matches found. Applied per file.
+ */
+int hyperscanner_scan_tree(
+    hyperscanner_t* scanner,
+    char* root,
+    hs_path_event on_file,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    char** files = NULL;
+    unsigned int file_count = 0;
+    unsigned int capacity = 0;
+    int first_error = 0;
+    int ret = tree_collect(root, &files, &file_count, &capacity);
+
+    if (ret == 0 && file_count > 0) {
+        if (max_match_count > 0 && max_match_count < buffer_count) {
+            // If there is a low cap on allowed matches, decrease the buffer size to optimize memory usage.
+            buffer_count = max_match_count;
+        }
+
+        // Initialize state shared by every file in the tree. If any part cannot be created, skip processing.
+        hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+        if (!state) {
+            ret = HYPERSCANNER_STATE_MEM;
+        } else {
+            memset(state, 0, sizeof(hyperscanner_state_t));
+            state->callback = on_event;
+            state->max_match_count = max_match_count;
+            state->skip_binary = scanner->skip_binary;
+            state->invert = scanner->invert;
+            state->line_dedup = scanner->line_dedup;
+
+            state->result_index = -1;
+            state->max_result_index = buffer_count - 1;
+            int max_results = state->max_result_index + 1;
+            ret = acquire_scan_buffers(state, scanner, max_results);
+            if (ret == 0 && scanner->single_match) {
+                state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+                if (!state->dedup_ids) {
+                    ret = HYPERSCANNER_COMPILE_MEM;
+                }
+            }
+            if (ret == 0) {
+                ret = setup_context(state, scanner);
+            }
+
+            unsigned int advised = 0;
+            for (unsigned int index = 0; ret == 0 && index < file_count; index++) {
+                // Keep a window of upcoming files loading in the background while this one scans.
+                unsigned int advise_until = index + HYPERSCANNER_TREE_READAHEAD;
+                if (advise_until > file_count) {
+                    advise_until = file_count;
+                }
+                for (; advised < advise_until; advised++) {
+                    tree_readahead(files[advised]);
+                }
+
+                // Reset the per file accounting while keeping every allocation for the next file.
+                state->match_count = 0;
+                state->line_number = 0;
+                state->dedup_id_count = 0;
+                state->dedup_line = 0;
+                state->dedup_line_done = 0;
+                state->file_index = index;
+                state->reported_through = 0;
+                state->after_pending = 0;
+                if (state->context_ring) {
+                    for (unsigned int entry = 0; entry < state->before_context; entry++) {
+                        state->context_ring[entry].used = 0;
+                    }
+                }
+                if (on_file) {
+                    on_file(index, files[index]);
+                }
+                int file_ret = route_scan(scanner, files[index], state, buffer_size, max_match_count);
+                // Flush before rewinding the arena so results never reference memory reused by the next file.
+                flush_results(state);
+                state->arena_offset = 0;
+                if (file_ret != 0 && first_error == 0) {
+                    // Per file failures do not stop the walk, record the first and keep scanning.
+                    first_error = file_ret;
+                }
+            }
+
+            release_context(state);
+            free(state->dedup_ids);
+            release_scan_buffers(state, scanner);
+            free(state);
+        }
+    }
+    if (ret == 0) {
+        ret = first_error;
+    }
+
+    for (unsigned int index = 0; index < file_count; index++) {
+        free(files[index]);
+    }
+    free(files);
+    return ret;
+}
+
+/*
+ * Count matches in a single file per pattern id without materializing any lines.
+ *
+ * Memory flat fast path for grep -c style workloads: matches are tallied directly in the caller's
+ * array with no result buffers, no line copies, and no callback crossings. Single match semantics
+ * from the handle still apply, so with HS_FLAG_SINGLEMATCH patterns the tallies are matching lines.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file that can be read line by line.
+ * counts: Caller provided array receiving the match count for each pattern id. Zeroed before scanning.
+ * count_elements: How many entries are in counts. Matches for ids beyond the array are not tallied.
+ * buffer_size: How large of a char buffer to use while reading compressed files line by line.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscanner_count_file(
+    hyperscanner_t* scanner,
+    char* file_name,
+    unsigned long long* counts,
+    const unsigned int count_elements,
+    const int buffer_size,
+    unsigned long long max_match_count
+) {
+    int ret = 0;
+
+    memset(counts, 0, sizeof(unsigned long long) * count_elements);
+
+    hyperscanner_state_t* state = (hyperscanner_state_t*) malloc(sizeof(hyperscanner_state_t));
+    if (!state) {
+        ret = HYPERSCANNER_STATE_MEM;
+        goto cleanup;
+    }
+    memset(state, 0, sizeof(hyperscanner_state_t));
+    state->result_index = -1;
+    state->max_match_count = max_match_count;
+    state->counts = counts;
+    state->count_elements = count_elements;
+    state->skip_binary = scanner->skip_binary;
+    state->invert = scanner->invert;
+    state->line_dedup = scanner->line_dedup;
+    if (scanner->single_match) {
+        // Track which pattern ids already reported for the current line to enforce single match semantics.
+        state->dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        if (!state->dedup_ids) {
+            ret = HYPERSCANNER_COMPILE_MEM;
+            goto cleanup;
+        }
+    }
+
+    // Every path now scans decoded blocks in place, so counting needs no arena on any file type.
+    ret = route_scan(scanner, file_name, state, buffer_size, max_match_count);
+
+cleanup:
+    if (state) {
+        free(state->dedup_ids);
+        free(state->arena);
+        free(state);
+    }
+    return ret;
+}
+
+/*
+ * Scan a single uncompressed file with multiple threads, merging results back into file order.
+ *
+ * The file is split into newline aligned segments, each scanned by a worker with its own scratch space
+ * cloned from the handle prototype. Results are collected per worker and replayed to the callback in
+ * file order after all workers finish, so callers observe the same ordering as a serial scan.
+ * Multi-member gzip archives decompress their members in parallel instead of segmenting bytes.
+ * Other compressed files and single thread requests fall back to the serial path.
+ *
+ * scanner: Handle previously initialized by hyperscanner_create().
+ * file_name: Location of a local file.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings per worker.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop after requested number of matches found. Applied per worker during scanning,
+ *     and enforced globally while merging, so a few extra matches may be scanned but never reported.
+ * thread_count: How many worker threads to scan with. Clamped so every worker has at least one full block.
+ */
+int hyperscanner_scan_file_parallel(
+    hyperscanner_t* scanner,
+    char* file_name,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    int thread_count
+) {
+    // Serial requests, and compressed files which must be decoded sequentially, use the single threaded path.
+    // Multi-member gzip archives are the exception: their members decode independently, so they are
+    // attempted in parallel first. Inverted and context scans stay on the serial decode path.
+    if (strcmp(file_name, "-") == 0) {
+        // Streams cannot be mapped or split into segments, scan stdin serially.
+        return hyperscanner_scan_file(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    struct stat file_stat;
+    if (stat(file_name, &file_stat) == 0 && !S_ISREG(file_stat.st_mode)) {
+        // FIFOs and other special files cannot be mapped either, the serial path streams them.
+        return hyperscanner_scan_file(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    hyperscanner_file_type_t file_type = detect_file_type(file_name);
+    if (thread_count > 1 && file_type == HYPERSCANNER_FILE_GZIP && !scanner->skip_binary && !scanner->invert
+        && !scanner->before_context && !scanner->after_context) {
+        int gz_ret = hyperscan_gz_parallel(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count, thread_count);
+        if (gz_ret != -1) {
+            return gz_ret;
+        }
+    }
+    if (thread_count <= 1 || file_type != HYPERSCANNER_FILE_PLAIN || scanner->invert
+        || scanner->before_context || scanner->after_context) {
+        // Inverted and context scans track neighboring lines across whole blocks, segment workers
+        // would drop the modes, so both stay on the serial path.
+        return hyperscanner_scan_file(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count);
+    }
+
+    const char* data = NULL;
+    size_t file_size = 0;
+    int ret = map_input_file(file_name, &data, &file_size);
+    if (ret != 0 || file_size == 0) {
+        return ret;
+    }
+    if (scanner->skip_binary && is_binary_data(data, file_size)) {
+        munmap((void*) data, file_size);
+        return HYPERSCANNER_BINARY;
+    }
+
+    // Clamp workers so each one covers at least a full block, small files gain nothing from more threads.
+    size_t max_workers = file_size / HYPERSCANNER_BLOCK_SIZE;
+    if (max_workers == 0) {
+        max_workers = 1;
+    }
+    int workers_count = thread_count < (int) max_workers ? thread_count : (int) max_workers;
+    if (workers_count == 1) {
+        // Remapping on the serial path is cheap relative to scanning a file this small.
+        munmap((void*) data, file_size);
+        return hyperscanner_scan_file(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count);
+    }
+
+    parallel_worker_t* workers = (parallel_worker_t*) calloc(workers_count, sizeof(parallel_worker_t));
+    if (!workers) {
+        munmap((void*) data, file_size);
+        return HYPERSCANNER_STATE_MEM;
+    }
+
+    // Carve the file into newline aligned segments so no line is ever split across workers.
+    int started = 0;
+    size_t segment_start = 0;
+    for (int index = 0; index < workers_count && segment_start < file_size && ret == 0; index++) {
+        size_t segment_end = file_size * (index + 1) / workers_count;
+        if (index == workers_count - 1 || segment_end >= file_size) {
+            segment_end = file_size;
+        } else {
+            if (segment_end <= segment_start) {
+                segment_end = segment_start;
+            }
+            const char* next_newline = memchr(data + segment_end, '\n', file_size - segment_end);
+            segment_end = next_newline ? (size_t) (next_newline - data) + 1 : file_size;
+        }
+
+        parallel_worker_t* worker = &workers[index];
+        worker->db = scanner->db;
+        worker->segment = data + segment_start;
+        worker->segment_length = segment_end - segment_start;
+        worker->max_match_count = max_match_count;
+        worker->state.result_index = -1;
+        worker->state.block_base = segment_start;
+        worker->state.max_match_count = max_match_count;
+        worker->state.max_result_index = buffer_count - 1;
+        // Dedup state is per line and segments split at newlines, so folding matches the serial output.
+        worker->state.line_dedup = scanner->line_dedup;
+        worker->state.collector = &worker->collector;
+        worker->state.results = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * buffer_count);
+        worker->state.arena_size = (size_t) buffer_size * 2;
+        worker->state.arena = malloc(worker->state.arena_size);
+        if (scanner->single_match) {
+            worker->state.dedup_ids = (unsigned int*) malloc(sizeof(unsigned int) * scanner->elements);
+        }
+        if (!worker->state.results || !worker->state.arena || (scanner->single_match && !worker->state.dedup_ids)) {
+            ret = HYPERSCANNER_STATE_MEM;
+            break;
+        }
+        ret = scratch_pool_acquire(scanner, &worker->scratch);
+        if (ret != 0) {
+            break;
+        }
+        if (pthread_create(&worker->thread, NULL, parallel_worker_main, worker) != 0) {
+            scratch_pool_release(scanner, worker->scratch);
+            worker->scratch = NULL;
+            ret = HYPERSCANNER_STATE_MEM;
+            break;
+        }
+        started++;
+        segment_start = segment_end;
+    }
+
+    for (int index = 0; index < started; index++) {
+        pthread_join(workers[index].thread, NULL);
+        if (ret == 0 && workers[index].ret != 0) {
+            ret = workers[index].ret;
+        }
+    }
+
+    // Replay the collected results in file order through the caller's batching, adjusting the
+    // per-segment line numbers by the total line count of every preceding segment.
+    hyperscanner_result_t* batch = (hyperscanner_result_t*) malloc(sizeof(hyperscanner_result_t) * buffer_count);
+    if (!batch) {
+        ret = ret ? ret : HYPERSCANNER_STATE_MEM;
+    } else {
+        unsigned long long line_base = 0;
+        unsigned long long emitted = 0;
+        int batch_index = 0;
+        for (int index = 0; index < started; index++) {
+            parallel_worker_t* worker = &workers[index];
+            for (size_t result_index = 0; result_index < worker->collector.count; result_index++) {
+                if (max_match_count > 0 && emitted >= max_match_count) {
+                    break;
+                }
+                batch[batch_index] = worker->collector.results[result_index];
+                batch[batch_index].line = worker->collector.lines + worker->collector.line_offsets[result_index];
+                batch[batch_index].line_number += line_base;
+                batch_index++;
+                emitted++;
+                if (batch_index == buffer_count) {
+                    on_event(batch, batch_index);
+                    batch_index = 0;
+                }
+            }
+            line_base += worker->state.line_number;
+        }
+        if (batch_index > 0) {
+            on_event(batch, batch_index);
+        }
+        free(batch);
+    }
+
+    for (int index = 0; index < workers_count; index++) {
+        parallel_worker_t* worker = &workers[index];
+        scratch_pool_release(scanner, worker->scratch);
+        free(worker->state.dedup_ids);
+        free(worker->state.arena);
+        free(worker->state.results);
+        free(worker->collector.results);
+        free(worker->collector.line_offsets);
+        free(worker->collector.lines);
+    }
+    free(workers);
+    munmap((void*) data, file_size);
+    return ret;
+}
+
+/*
+ * Scan a file using Intel Hyperscan for high performance using multiple regexes.
+ *
+ * Compiles a single use database and scratch space. Use hyperscanner_create() and hyperscanner_scan_file()
+ * when the same patterns will be applied to multiple files, to pay the compilation cost only once.
+ *
+ * file_name: Location of a local file that can be read line by line.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ *     Flags in hyperscan use a bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH == 10
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ *     Provide unique IDs if every pattern should return matches for a line, even if another pattern already matched.
+ * elements: Size the pattern array.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event. Lines are shared from the arena.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_file(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Scan a file using single use patterns while collecting per stage performance counters.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_file_stats() + destroy.
+ * Database compilation time is not included in the counters.
+ *
+ * file_name: Location of a local file that can be read line by line.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ * stats: Caller provided counters filled during the scan.
+ */
+int hyperscan_stats(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    hyperscanner_stats_t* stats
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_file_stats(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count, stats);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Scan a single file through caller provided shared memory using single use patterns.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_file_shared() + destroy.
+ * See hyperscanner_scan_file_shared() for the shared transport contract.
+ *
+ * file_name: Location of a local file that can be read line by line.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_event: Function signalled with only the filled slot count after each batch.
+ * arena: Caller provided buffer that receives the NUL terminated result lines.
+ * arena_size: Total capacity of arena in bytes.
+ * slots: Caller provided table receiving one record per result in the current batch.
+ * slot_count: How many entries are in slots, and therefore the result batch size.
+ * buffer_size: How large of a char buffer to use while reading compressed files line by line.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan_shared(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_shared_event on_event,
+    char* arena,
+    unsigned long long arena_size,
+    hyperscanner_shared_result_t* slots,
+    int slot_count,
+    const int buffer_size,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_file_shared(scanner, file_name, on_event, arena, arena_size, slots, slot_count, buffer_size, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Scan one byte range of an uncompressed file using single use patterns.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_range() + destroy.
+ * See hyperscanner_scan_range() for range boundary semantics.
+ *
+ * file_name: Location of a local uncompressed file.
+ * start_offset: First byte of the range. Lines beginning before this offset belong to the previous range.
+ * end_offset: One past the last byte of the range. Clamped to the file size.
+ * line_number_hint: How many lines precede start_offset, so results report absolute line numbers.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop reading the range after requested number of matches found.
+ */
+int hyperscan_range(
+    char* file_name,
+    unsigned long long start_offset,
+    unsigned long long end_offset,
+    unsigned long long line_number_hint,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_range(scanner, file_name, start_offset, end_offset, line_number_hint, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Scan a list of files using single use patterns, with one native call for the whole batch.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_files() + destroy.
+ * See hyperscanner_scan_files() for batching and failure semantics.
+ *
+ * file_names: Locations of local files that can be read line by line.
+ * file_count: How many entries are in file_names.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop reading each file after requested number of matches found. Applied per file.
+ */
+int hyperscan_files(
+    char** file_names,
+    const unsigned int file_count,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_files(scanner, file_names, file_count, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Recursively scan every regular file under a directory using single use patterns.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_tree() + destroy.
+ * See hyperscanner_scan_tree() for walk order, readahead, and failure semantics.
+ *
+ * root: Directory to walk recursively.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_file: Function to call with each file's index and path before its results are emitted.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings. Reads up to first newline or len - 1.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop reading each file after requested number of matches found. Applied per file.
+ */
+int hyperscan_tree(
+    char* root,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_path_event on_file,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_tree(scanner, root, on_file, on_event, buffer_size, buffer_count, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Count matches in a file per pattern id using single use patterns.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_count_file() + destroy.
+ * See hyperscanner_count_file() for count only semantics.
+ *
+ * file_name: Location of a local file that can be read line by line.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * counts: Caller provided array receiving the match count for each pattern id.
+ * count_elements: How many entries are in counts.
+ * buffer_size: How large of a char buffer to use while reading compressed files line by line.
+ * max_match_count: Stop reading the file after requested number of matches found.
+ */
+int hyperscan_count(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    unsigned long long* counts,
+    const unsigned int count_elements,
+    const int buffer_size,
+    unsigned long long max_match_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_count_file(scanner, file_name, counts, count_elements, buffer_size, max_match_count);
+    }
+    hyperscanner_destroy(scanner);
+    return ret;
+}
+
+/*
+ * Scan a single file with multiple threads using single use patterns.
+ *
+ * Convenience wrapper equivalent to hyperscanner_create() + hyperscanner_scan_file_parallel() + destroy.
+ * See hyperscanner_scan_file_parallel() for segmenting, ordering, and fallback behavior.
+ *
+ * file_name: Location of a local file.
+ * patterns: Regular expressions to be scanned against every line.
+ * pattern_flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+ * pattern_ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+ * elements: Size the pattern array.
+ * on_event: Function to call with simplified match information from Intel Hyperscan.
+ * buffer_size: How large of a char buffer to use while reading in strings per worker.
+ * buffer_count: How many results should be buffered before batching to on_event.
+ * max_match_count: Stop after requested number of matches found.
+ * thread_count: How many worker threads to scan with.
+ */
+int hyperscan_parallel(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count,
+    int thread_count
+) {
+    hyperscanner_t* scanner = NULL;
+    int ret = hyperscanner_create(&scanner, patterns, pattern_flags, pattern_ids, elements, NULL);
+    if (ret == 0) {
+        ret = hyperscanner_scan_file_parallel(scanner, file_name, on_event, buffer_size, buffer_count, max_match_count, thread_count);
+    }
+    hyperscanner_destroy(scanner);
     return ret;
 }
 
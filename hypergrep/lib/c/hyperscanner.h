@@ -5,6 +5,33 @@
 #ifndef hyperscanner_h__
 #define hyperscanner_h__
 
-extern int hyperscan(char* fileName, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event onEvent, const int bufSize)
+extern int hyperscan(char* file_name, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscanner_create(hyperscanner_t** scanner, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, const char* db_cache_path);
+extern void hyperscanner_set_binary_skip(hyperscanner_t* scanner, int skip_binary);
+extern void hyperscanner_set_context(hyperscanner_t* scanner, unsigned int before_context, unsigned int after_context);
+extern void hyperscanner_set_invert(hyperscanner_t* scanner, int invert);
+extern void hyperscanner_set_line_dedup(hyperscanner_t* scanner, int line_dedup);
+extern void hyperscanner_set_scratch_pool(hyperscanner_t* scanner, int pool_size);
+extern void hyperscanner_set_counters(hyperscanner_t* scanner, int counters);
+extern int hyperscanner_count_file(hyperscanner_t* scanner, char* file_name, unsigned long long* counts, const unsigned int count_elements, const int buffer_size, unsigned long long max_match_count);
+extern int hyperscan_count(char* file_name, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, unsigned long long* counts, const unsigned int count_elements, const int buffer_size, unsigned long long max_match_count);
+extern int hyperscanner_scan_file(hyperscanner_t* scanner, char* file_name, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscanner_scan_file_stats(hyperscanner_t* scanner, char* file_name, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count, hyperscanner_stats_t* stats);
+extern int hyperscan_stats(char* file_name, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count, hyperscanner_stats_t* stats);
+extern int hyperscanner_scan_file_shared(hyperscanner_t* scanner, char* file_name, hs_shared_event on_event, char* arena, unsigned long long arena_size, hyperscanner_shared_result_t* slots, int slot_count, const int buffer_size, unsigned long long max_match_count);
+extern int hyperscan_shared(char* file_name, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_shared_event on_event, char* arena, unsigned long long arena_size, hyperscanner_shared_result_t* slots, int slot_count, const int buffer_size, unsigned long long max_match_count);
+extern int hyperscanner_scan_range(hyperscanner_t* scanner, char* file_name, unsigned long long start_offset, unsigned long long end_offset, unsigned long long line_number_hint, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscan_range(char* file_name, unsigned long long start_offset, unsigned long long end_offset, unsigned long long line_number_hint, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscanner_scan_files(hyperscanner_t* scanner, char** file_names, const unsigned int file_count, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscan_files(char** file_names, const unsigned int file_count, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscanner_scan_tree(hyperscanner_t* scanner, char* root, hs_path_event on_file, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscan_tree(char* root, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_path_event on_file, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count);
+extern int hyperscanner_scan_file_parallel(hyperscanner_t* scanner, char* file_name, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count, int thread_count);
+extern int hyperscan_parallel(char* file_name, const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements, hs_event on_event, const int buffer_size, int buffer_count, unsigned long long max_match_count, int thread_count);
+extern void hyperscanner_destroy(hyperscanner_t* scanner);
+extern int hyperscan_zstd(char* file_name, hyperscanner_state_t* state, hyperscanner_t* scanner, unsigned long long max_match_count);
+extern int hyperscan_fd(int fd, hyperscanner_state_t* state, hyperscanner_t* scanner, unsigned long long max_match_count);
+extern int hyperscan_mmap(char* file_name, hyperscanner_state_t* state, hs_database_t* db, hs_scratch_t* scratch, unsigned long long max_match_count);
+extern int check_patterns(const char* const* patterns, const unsigned int* pattern_flags, const unsigned int* pattern_ids, const unsigned int elements);
 
 #endif
@@ -0,0 +1,331 @@
+/*
+ * Standalone benchmark harness for the hyperscanner shared library.
+ *
+ * Generates corpora with controlled line lengths, match densities, and encodings, then times
+ * hyperscan() over every configuration across multiple pattern set sizes, reporting MB/s of
+ * decoded input and matches/s. Used to verify performance changes to hyperscanner.c and to
+ * qualify new hardware without going through the Python layer.
+ *
+ * Build and run with "make bench" from the repository root. Loads the prebuilt shared libraries
+ * at runtime in dependency order, mirroring configure_libraries() in the Python layer, so only
+ * the benchmark recompiles between runs.
+ *
+ * Usage:
+ *     ./hyperscanner_bench <lib dir> [corpus megabytes]
+ */
+
+// Required for mkdtemp() and other extensions under strict C99 builds.
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Pattern flag values mirroring hs_compile.h, the benchmark does not include the Hyperscan headers.
+#define BENCH_HS_FLAG_DOTALL 2
+#define BENCH_HS_FLAG_MULTILINE 4
+
+// How many bytes of decoded corpus to generate per line length by default.
+#define BENCH_DEFAULT_CORPUS_MB 64
+// Longest path and shell command the benchmark builds.
+#define BENCH_PATH_MAX 4096
+
+// Line lengths in bytes, spanning terse metric lines through wide application log lines.
+static const size_t bench_line_lengths[] = {64, 512, 4096};
+// Matching lines per 10000, i.e. 0%, 0.1%, and 10% match density.
+static const unsigned int bench_densities[] = {0, 10, 1000};
+// Pattern set sizes. Only the first pattern ever matches, larger sets measure engine overhead.
+static const unsigned int bench_pattern_counts[] = {1, 8, 64};
+
+/*
+ * Match result layout mirroring hyperscanner_result_t in hyperscanner.c.
+ */
+typedef struct hyperscanner_result {
+    unsigned int id;
+    unsigned long long line_number;
+    char* line;
+    unsigned int length;
+    unsigned long long match_start;
+    unsigned long long match_end;
+    unsigned int file_index;
+    unsigned int context;
+    unsigned long long id_mask;
+    unsigned long long byte_offset;
+} hyperscanner_result_t;
+
+typedef void (*hs_event)(hyperscanner_result_t* results, int result_count);
+
+typedef int (*hyperscan_fn)(
+    char* file_name,
+    const char* const* patterns,
+    const unsigned int* pattern_flags,
+    const unsigned int* pattern_ids,
+    const unsigned int elements,
+    hs_event on_event,
+    const int buffer_size,
+    int buffer_count,
+    unsigned long long max_match_count
+);
+
+// Entry point resolved from the shared library at startup.
+static hyperscan_fn bench_hyperscan;
+
+/*
+ * Load the bundled shared libraries in dependency order and resolve hyperscan().
+ *
+ * Dependencies are loaded globally before libhyperscanner so its unresolved symbols bind to the
+ * bundled versions, the same order configure_libraries() uses in the Python layer.
+ *
+ * lib_dir: Directory holding libzstd, libhs, and libhyperscanner, normally hypergrep/lib.
+ */
+static int bench_load(const char* lib_dir) {
+    static const char* const libraries[] = {"libzstd.so.1.5.5", "libhs.so.5.4.2", "libhyperscanner.so"};
+    char path[BENCH_PATH_MAX];
+    void* handle = NULL;
+    for (size_t index = 0; index < sizeof(libraries) / sizeof(libraries[0]); index++) {
+        snprintf(path, sizeof(path), "%s/%s", lib_dir, libraries[index]);
+        handle = dlopen(path, RTLD_NOW | RTLD_GLOBAL);
+        if (!handle) {
+            fprintf(stderr, "ERROR: Unable to load %s: %s\n", path, dlerror());
+            return 1;
+        }
+    }
+    bench_hyperscan = (hyperscan_fn) dlsym(handle, "hyperscan");
+    if (!bench_hyperscan) {
+        fprintf(stderr, "ERROR: Unable to resolve hyperscan(): %s\n", dlerror());
+        return 1;
+    }
+    return 0;
+}
+
+// Total matches reported by the current timed scan.
+static unsigned long long bench_matches;
+
+/*
+ * Tally result batches during timed scans without any per-result work.
+ *
+ * results: Batch of matches from the scanner. Unused beyond the count.
+ * result_count: How many results are in the batch.
+ */
+static void bench_on_event(hyperscanner_result_t* results, int result_count) {
+    (void) results;
+    bench_matches += result_count;
+}
+
+/*
+ * Read the monotonic clock as seconds for throughput math.
+ */
+static double bench_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec / 1000000000.0;
+}
+
+/*
+ * Write one plain text corpus of fixed length lines with a controlled match density.
+ *
+ * Lines are pseudo random lowercase text from a fixed seed so runs are reproducible. Matching
+ * lines embed the first benchmark pattern near the middle of the line.
+ *
+ * path: Location to write the corpus.
+ * line_length: Bytes per line excluding the newline.
+ * density: Matching lines per 10000.
+ * total_bytes: Approximate decoded size of the corpus.
+ */
+static int bench_write_corpus(const char* path, size_t line_length, unsigned int density, size_t total_bytes) {
+    FILE* output = fopen(path, "w");
+    if (!output) {
+        return 1;
+    }
+    char* line = malloc(line_length + 2);
+    if (!line) {
+        fclose(output);
+        return 1;
+    }
+    srand(42);
+    size_t line_count = total_bytes / (line_length + 1);
+    for (size_t index = 0; index < line_count; index++) {
+        for (size_t pos = 0; pos < line_length; pos++) {
+            line[pos] = (char) ('a' + rand() % 26);
+        }
+        if (density > 0 && index % 10000 < density) {
+            memcpy(line + line_length / 2, "needle0000", 10);
+        }
+        line[line_length] = '\n';
+        line[line_length + 1] = '\0';
+        if (fputs(line, output) == EOF) {
+            free(line);
+            fclose(output);
+            return 1;
+        }
+    }
+    free(line);
+    fclose(output);
+    return 0;
+}
+
+/*
+ * Compress the plain corpus into a sibling file using a system encoder.
+ *
+ * Missing encoders are tolerated, the configuration is reported as skipped instead of failing
+ * the whole run.
+ *
+ * command: Shell command producing the compressed file from the plain one.
+ */
+static int bench_encode(const char* command) {
+    int ret = system(command);
+    return ret == 0 ? 0 : 1;
+}
+
+/*
+ * Time hyperscan() over one corpus file and print the throughput row.
+ *
+ * Runs once untimed to warm the page cache and database free paths, then once timed.
+ *
+ * encoding: Label for the corpus encoding, e.g. plain/gz/zst.
+ * path: Location of the corpus file.
+ * line_length: Bytes per line, for the report only.
+ * density: Matching lines per 10000, for the report only.
+ * pattern_count: How many patterns to compile into the database.
+ * decoded_bytes: Decoded size of the corpus, the basis for MB/s across all encodings.
+ */
+static int bench_run(
+    const char* encoding,
+    char* path,
+    size_t line_length,
+    unsigned int density,
+    unsigned int pattern_count,
+    size_t decoded_bytes
+) {
+    char** patterns = malloc(sizeof(char*) * pattern_count);
+    unsigned int* flags = malloc(sizeof(unsigned int) * pattern_count);
+    unsigned int* ids = malloc(sizeof(unsigned int) * pattern_count);
+    if (!patterns || !flags || !ids) {
+        free(patterns);
+        free(flags);
+        free(ids);
+        return 1;
+    }
+    for (unsigned int index = 0; index < pattern_count; index++) {
+        char pattern[32];
+        snprintf(pattern, sizeof(pattern), "needle%04u", index);
+        patterns[index] = strdup(pattern);
+        flags[index] = BENCH_HS_FLAG_DOTALL | BENCH_HS_FLAG_MULTILINE;
+        ids[index] = index;
+    }
+
+    int ret = 0;
+    for (int timed = 0; timed <= 1; timed++) {
+        bench_matches = 0;
+        double begin = bench_now();
+        ret = bench_hyperscan(path, (const char* const*) patterns, flags, ids, pattern_count, bench_on_event, 262140, 16, 0);
+        if (ret != 0) {
+            fprintf(stderr, "ERROR: Scan failed with return code %d for %s\n", ret, path);
+            break;
+        }
+        if (timed) {
+            double elapsed = bench_now() - begin;
+            printf(
+                "%-6s %10zu %9.2f%% %9u %10.1f %12.0f\n",
+                encoding,
+                line_length,
+                density / 100.0,
+                pattern_count,
+                decoded_bytes / elapsed / (1024.0 * 1024.0),
+                bench_matches / elapsed
+            );
+        }
+    }
+
+    for (unsigned int index = 0; index < pattern_count; index++) {
+        free(patterns[index]);
+    }
+    free(patterns);
+    free(flags);
+    free(ids);
+    return ret;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <lib dir> [corpus megabytes]\n", argv[0]);
+        return 1;
+    }
+    if (bench_load(argv[1]) != 0) {
+        return 1;
+    }
+    size_t corpus_bytes = (size_t) (argc > 2 ? atoi(argv[2]) : BENCH_DEFAULT_CORPUS_MB) * 1024 * 1024;
+
+    char corpus_dir[] = "/tmp/hyperscanner_bench.XXXXXX";
+    if (!mkdtemp(corpus_dir)) {
+        fprintf(stderr, "ERROR: Unable to create corpus directory\n");
+        return 1;
+    }
+
+    printf("corpus %zu MB per configuration, warm cache, single scan timed\n", corpus_bytes / (1024 * 1024));
+    printf("%-6s %10s %10s %9s %10s %12s\n", "enc", "line_bytes", "match", "patterns", "MB/s", "matches/s");
+
+    int ret = 0;
+    char plain_path[BENCH_PATH_MAX];
+    char encoded_path[BENCH_PATH_MAX + 8];
+    char command[BENCH_PATH_MAX * 2];
+    for (size_t length_index = 0; length_index < sizeof(bench_line_lengths) / sizeof(bench_line_lengths[0]); length_index++) {
+        size_t line_length = bench_line_lengths[length_index];
+        for (size_t density_index = 0; density_index < sizeof(bench_densities) / sizeof(bench_densities[0]); density_index++) {
+            unsigned int density = bench_densities[density_index];
+            snprintf(plain_path, sizeof(plain_path), "%s/corpus_%zu_%u.log", corpus_dir, line_length, density);
+            if (bench_write_corpus(plain_path, line_length, density, corpus_bytes) != 0) {
+                fprintf(stderr, "ERROR: Unable to write corpus %s\n", plain_path);
+                ret = 1;
+                goto cleanup;
+            }
+
+            // Compressed variants reuse the plain corpus so every encoding scans identical bytes.
+            snprintf(command, sizeof(command), "gzip -kf %s 2>/dev/null", plain_path);
+            int have_gz = bench_encode(command) == 0;
+            snprintf(command, sizeof(command), "zstd -qkf %s 2>/dev/null", plain_path);
+            int have_zst = bench_encode(command) == 0;
+
+            for (size_t count_index = 0; count_index < sizeof(bench_pattern_counts) / sizeof(bench_pattern_counts[0]); count_index++) {
+                unsigned int pattern_count = bench_pattern_counts[count_index];
+                if (bench_run("plain", plain_path, line_length, density, pattern_count, corpus_bytes) != 0) {
+                    ret = 1;
+                    goto cleanup;
+                }
+                if (have_gz) {
+                    snprintf(encoded_path, sizeof(encoded_path), "%s.gz", plain_path);
+                    if (bench_run("gz", encoded_path, line_length, density, pattern_count, corpus_bytes) != 0) {
+                        ret = 1;
+                        goto cleanup;
+                    }
+                }
+                if (have_zst) {
+                    snprintf(encoded_path, sizeof(encoded_path), "%s.zst", plain_path);
+                    if (bench_run("zst", encoded_path, line_length, density, pattern_count, corpus_bytes) != 0) {
+                        ret = 1;
+                        goto cleanup;
+                    }
+                }
+            }
+            if (!have_gz || !have_zst) {
+                printf("note: missing %s%s encoder, configurations skipped\n", have_gz ? "" : "gzip ", have_zst ? "" : "zstd");
+            }
+
+            unlink(plain_path);
+            snprintf(encoded_path, sizeof(encoded_path), "%s.gz", plain_path);
+            unlink(encoded_path);
+            snprintf(encoded_path, sizeof(encoded_path), "%s.zst", plain_path);
+            unlink(encoded_path);
+        }
+    }
+
+cleanup:
+    snprintf(command, sizeof(command), "rm -rf %s", corpus_dir);
+    if (system(command) != 0) {
+        fprintf(stderr, "WARNING: Unable to remove corpus directory %s\n", corpus_dir);
+    }
+    return ret;
+}
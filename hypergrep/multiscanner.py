@@ -146,6 +146,9 @@ def parallel_grep(  # This cannot be shortened due to parallel pool usage. pylin
             pending[grep_index] = grep_result
             return
         file_name = files[grep_index]
+        if file_name == "-":
+            # Match grep output format when scanning the standard input stream.
+            file_name = "(standard input)"
         if isinstance(grep_result, Exception):
             # Error message style taken from "grep" output format.
             print(f"hyperscanner: {file_name}: {grep_result}")
@@ -370,7 +373,7 @@ def parse_args(args: list = None) -> argparse.Namespace:
 
     # Arguments reserved by "grep". Argparse groups match "grep" help output organization:
     parser.add_argument("pattern", nargs="?", help="Regex pattern to use.")
-    parser.add_argument("files", nargs="*", help="Files to scan.")
+    parser.add_argument("files", nargs="*", help='Files to scan. Use "-" to stream standard input.')
 
     generic_args = parser.add_argument_group("Generic Program Information")
     # Add help manually, using only --help. Grep uses -h as a standard arg.
@@ -2,10 +2,13 @@
 
 import argparse
 import builtins
+import gzip
 import io
 import os
 import shlex
 import sys
+import tempfile
+import threading
 from typing import Any
 from typing import Callable
 
@@ -23,6 +26,46 @@ def _basic_callback(matches: list, count: int) -> None:
         print(f"{match.line_number}:{line.rstrip()}")
 
 
+def _context_callback(matches: list, count: int) -> None:
+    """Callback for C library to send results including context lines around matches."""
+    for index in range(count):
+        match = matches[index]
+        line = match.line.decode(errors="ignore")
+        print(f"{match.context}:{match.line_number}:{line.rstrip()}")
+
+
+def _shared_callback(arena: memoryview, slots: Any, count: int) -> None:
+    """Callback for C library shared memory batches, slicing lines lazily from the arena."""
+    for index in range(count):
+        slot = slots[index]
+        line = bytes(arena[slot.line_offset : slot.line_offset + slot.length]).decode(errors="ignore")
+        print(f"{slot.line_number}:{line.rstrip()}")
+
+
+def _line_dedup_callback(matches: list, count: int) -> None:
+    """Callback for C library to send deduped results with the accumulated pattern id mask."""
+    for index in range(count):
+        match = matches[index]
+        line = match.line.decode(errors="ignore")
+        print(f"{match.id_mask}:{match.line_number}:{line.rstrip()}")
+
+
+def _byte_offset_callback(matches: list, count: int) -> None:
+    """Callback for C library to send results with the absolute byte offset of each line."""
+    for index in range(count):
+        match = matches[index]
+        line = match.line.decode(errors="ignore")
+        print(f"{match.byte_offset}:{match.line_number}:{line.rstrip()}")
+
+
+def _file_index_callback(matches: list, count: int) -> None:
+    """Callback for C library to send results from multi-file batches."""
+    for index in range(count):
+        match = matches[index]
+        line = match.line.decode(errors="ignore")
+        print(f"{match.file_index}:{match.line_number}:{line.rstrip()}")
+
+
 TEST_ROOT = os.path.dirname(__file__)
 GREP_FILE_1 = os.path.join(TEST_ROOT, "greptest1.txt")
 GREP_FILE_2 = os.path.join(TEST_ROOT, "greptest2.txt")
@@ -32,6 +75,37 @@ FAKE_FILES = {
 TEST_FILE = os.path.join(TEST_ROOT, "samplefile.txt")
 TEST_FILE_GZ = os.path.join(TEST_ROOT, f"{TEST_FILE}.gz")
 TEST_FILE_ZST = os.path.join(TEST_ROOT, f"{TEST_FILE}.zst")
+TEST_TREE = os.path.join(TEST_ROOT, "tree")
+PARALLEL_FILLER = "abcdefghijklmnopqrstuvwxyz 0123456789"
+PARALLEL_NEEDLES = (1000, 149999, 150001, 250000)
+PARALLEL_FIXTURES: dict = {}
+
+
+def _parallel_fixture(kind: str) -> str:
+    """Create and cache an oversized fixture that exercises the native parallel scan paths.
+
+    Args:
+        kind: Which fixture to build. "plain" is an uncompressed file spanning multiple native blocks
+            so it splits into segments, and "gzip" is a multi member archive equivalent to
+            concatenated rotated logs so its members decode on separate workers.
+
+    Returns:
+        Location of the generated file.
+    """
+    if kind not in PARALLEL_FIXTURES:
+        path = os.path.join(tempfile.gettempdir(), f"hypergrep_parallel_{os.getpid()}.{kind}")
+        if kind == "plain":
+            with open(path, "w", encoding="utf-8") as out_file:
+                for index in range(300000):
+                    out_file.write(f"needle {index}\n" if index in PARALLEL_NEEDLES else f"{PARALLEL_FILLER}\n")
+        else:
+            with open(path, "wb") as out_file:
+                out_file.write(gzip.compress(b"alpha\nmatch one\nbeta\n"))
+                out_file.write(gzip.compress(b"gamma\nmatch two\ndelta\n"))
+        PARALLEL_FIXTURES[kind] = path
+    return PARALLEL_FIXTURES[kind]
+
+
 TEST_CASES = {
     "argparse_namespace_comparator": {
         "matched": {
@@ -208,6 +282,467 @@ TEST_CASES = {
             ],
         },
     },
+    "scanner": {
+        "one pattern, multiple files": {
+            "args": [
+                ["bar"],
+                [TEST_FILE, TEST_FILE_GZ, TEST_FILE_ZST],
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+                "1:foobar",
+                "2:barfoo",
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "two patterns, reused database": {
+            "args": [
+                [
+                    "bar",
+                    "food",
+                ],
+                [TEST_FILE, TEST_FILE],
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+                "3:food",
+                "1:foobar",
+                "2:barfoo",
+                "3:food",
+            ],
+        },
+        "dotall wildcard, match stays within one line": {
+            "args": [
+                ["foo.*bar"],
+                [TEST_FILE, TEST_FILE_GZ, TEST_FILE_ZST],
+            ],
+            "returns": [
+                "1:foobar",
+                "1:foobar",
+                "1:foobar",
+            ],
+        },
+        "dotall wildcard, no match across lines": {
+            "args": [
+                ["barfoo.*food"],
+                [TEST_FILE, TEST_FILE_GZ, TEST_FILE_ZST],
+            ],
+            "returns": [],
+        },
+    },
+    "scanner_context": {
+        "single match, before and after context": {
+            "args": [
+                ["barfoo"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "before_context": 1,
+                "after_context": 1,
+            },
+            "returns": [
+                "1:1:foobar",
+                "0:2:barfoo",
+                "2:3:food",
+            ],
+        },
+        "adjacent matches, no duplicated lines": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "before_context": 1,
+                "after_context": 1,
+            },
+            "returns": [
+                "1:0:foo",
+                "0:1:foobar",
+                "0:2:barfoo",
+                "2:3:food",
+            ],
+        },
+    },
+    "scanner_invert": {
+        "one pattern, plain text": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "invert": True,
+            },
+            "returns": [
+                "0:foo",
+                "3:food",
+            ],
+        },
+        "one pattern, gz": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "kwargs": {
+                "invert": True,
+            },
+            "returns": [
+                "0:foo",
+                "3:food",
+            ],
+        },
+        "no matches, every line reported": {
+            "args": [
+                ["nomatch"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "invert": True,
+            },
+            "returns": [
+                "0:foo",
+                "1:foobar",
+                "2:barfoo",
+                "3:food",
+            ],
+        },
+    },
+    "scanner_line_dedup": {
+        "overlapping patterns, one result per line": {
+            "args": [
+                ["foo", "bar"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "ids": [0, 1],
+                "line_dedup": True,
+            },
+            "returns": [
+                "1:0:foo",
+                "3:1:foobar",
+                "3:2:barfoo",
+                "1:3:food",
+            ],
+        },
+        "one pattern, gz": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "kwargs": {
+                "line_dedup": True,
+            },
+            "returns": [
+                "1:1:foobar",
+                "1:2:barfoo",
+            ],
+        },
+    },
+    "scanner_byte_offset": {
+        "one pattern, plain text": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "returns": [
+                "4:1:foobar",
+                "11:2:barfoo",
+            ],
+        },
+        "one pattern, gz, decoded offsets": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "returns": [
+                "4:1:foobar",
+                "11:2:barfoo",
+            ],
+        },
+    },
+    "scanner_stdin": {
+        "one pattern, plain text": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "one pattern, gz": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "one pattern, zst": {
+            "args": [
+                ["bar"],
+                TEST_FILE_ZST,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+    },
+    "scanner_fifo": {
+        "one pattern, plain text": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "one pattern, gz": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+    },
+    "scanner_parallel": {
+        "multi segment plain file, serial equivalent ordering": {
+            "args": [
+                ["needle"],
+                "plain",
+            ],
+            "kwargs": {
+                "threads": 4,
+            },
+            "returns": [
+                "1000:needle 1000",
+                "149999:needle 149999",
+                "150001:needle 150001",
+                "250000:needle 250000",
+            ],
+        },
+        "multi member gz archive, serial equivalent ordering": {
+            "args": [
+                ["match"],
+                "gzip",
+            ],
+            "kwargs": {
+                "threads": 2,
+            },
+            "returns": [
+                "1:match one",
+                "4:match two",
+            ],
+        },
+        "multi segment plain file, line dedup folds ids": {
+            "args": [
+                ["needle", "need"],
+                "plain",
+            ],
+            "kwargs": {
+                "ids": [0, 1],
+                "line_dedup": True,
+                "threads": 4,
+            },
+            "returns": [
+                "3:1000:needle 1000",
+                "3:149999:needle 149999",
+                "3:150001:needle 150001",
+                "3:250000:needle 250000",
+            ],
+        },
+        "multi member gz archive, line dedup folds ids": {
+            "args": [
+                ["match", "mat"],
+                "gzip",
+            ],
+            "kwargs": {
+                "ids": [0, 1],
+                "line_dedup": True,
+                "threads": 2,
+            },
+            "returns": [
+                "3:1:match one",
+                "3:4:match two",
+            ],
+        },
+        "multi segment plain file, inverted scan stays serial": {
+            "args": [
+                ["needle"],
+                "plain",
+            ],
+            "kwargs": {
+                "invert": True,
+                "threads": 4,
+                "max_match_count": 4,
+            },
+            "returns": [
+                f"0:{PARALLEL_FILLER}",
+                f"1:{PARALLEL_FILLER}",
+                f"2:{PARALLEL_FILLER}",
+                f"3:{PARALLEL_FILLER}",
+            ],
+        },
+        "multi segment plain file, context scan stays serial": {
+            "args": [
+                ["needle"],
+                "plain",
+            ],
+            "kwargs": {
+                "before_context": 1,
+                "after_context": 1,
+                "threads": 4,
+            },
+            "returns": [
+                f"1:999:{PARALLEL_FILLER}",
+                "0:1000:needle 1000",
+                f"2:1001:{PARALLEL_FILLER}",
+                f"1:149998:{PARALLEL_FILLER}",
+                "0:149999:needle 149999",
+                f"2:150000:{PARALLEL_FILLER}",
+                "0:150001:needle 150001",
+                f"2:150002:{PARALLEL_FILLER}",
+                f"1:249999:{PARALLEL_FILLER}",
+                "0:250000:needle 250000",
+                f"2:250001:{PARALLEL_FILLER}",
+            ],
+        },
+    },
+    "scanner_shared": {
+        "one pattern, plain text": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "one pattern, gz": {
+            "args": [
+                ["bar"],
+                TEST_FILE_GZ,
+            ],
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+        "single slot, multiple batches": {
+            "args": [
+                ["bar"],
+                TEST_FILE,
+            ],
+            "kwargs": {
+                "slot_count": 1,
+            },
+            "returns": [
+                "1:foobar",
+                "2:barfoo",
+            ],
+        },
+    },
+    "scanner_tree": {
+        "one pattern, nested directories": {
+            "args": [
+                ["bar"],
+                TEST_TREE,
+            ],
+            "returns": [
+                "alpha.txt:1:foobar",
+                "beta.txt:0:barfoo",
+            ],
+        },
+    },
+    "scan_files": {
+        "one pattern, multiple file types": {
+            "args": [
+                [TEST_FILE, TEST_FILE_GZ, TEST_FILE_ZST],
+                ["bar"],
+                _file_index_callback,
+            ],
+            "returns": [
+                "0:1:foobar",
+                "0:2:barfoo",
+                "1:1:foobar",
+                "1:2:barfoo",
+                "2:1:foobar",
+                "2:2:barfoo",
+            ],
+        },
+    },
+    "scan_range": {
+        "first shard, lines starting before the split": {
+            "args": [
+                TEST_FILE,
+                0,
+                11,
+                ["bar"],
+                _basic_callback,
+            ],
+            "returns": [
+                "1:foobar",
+            ],
+        },
+        "second shard, absolute line numbers via hint": {
+            "args": [
+                TEST_FILE,
+                11,
+                1000000,
+                ["bar"],
+                _basic_callback,
+            ],
+            "kwargs": {
+                "line_number_hint": 2,
+            },
+            "returns": [
+                "2:barfoo",
+            ],
+        },
+    },
+    "count": {
+        "two patterns, shared id": {
+            "args": [
+                TEST_FILE,
+                [
+                    "bar",
+                    "food",
+                ],
+            ],
+            "returns": (
+                [3],
+                0,
+            ),
+        },
+        "two patterns, unique ids": {
+            "args": [
+                TEST_FILE,
+                [
+                    "bar",
+                    "food",
+                ],
+            ],
+            "kwargs": {
+                "ids": [0, 1],
+            },
+            "returns": (
+                [2, 1],
+                0,
+            ),
+        },
+    },
     "grep": {
         "one pattern, no index": {
             "args": [
@@ -1044,6 +1579,16 @@ def test_get_argparse_patterns(test_case: dict, function_tester: Callable) -> No
     function_tester(test_case, multiscanner.get_argparse_patterns)
 
 
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["count"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_count(test_case: dict, function_tester: Callable) -> None:
+    """Tests for count function."""
+    function_tester(test_case, utils.count)
+
+
 @pytest.mark.parametrize_test_case("test_case", TEST_CASES["grep"])
 @pytest.mark.skipif(
     sys.platform != "linux",
@@ -1072,6 +1617,274 @@ def test_hyperscan(test_case: dict, capsys: Any, function_tester: Callable) -> N
     function_tester(test_case, _scan_helper)
 
 
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner reusable handle scans."""
+
+    def _scanner_helper(patterns: list, files: list) -> list:
+        """Helper to scan multiple files with one reusable scanner and capture output for comparisons."""
+        with utils.Scanner(patterns) as scanner:
+            for file in files:
+                scanner.scan(file, _basic_callback)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _scanner_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_context"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_context(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner context line reporting."""
+
+    def _context_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan with context enabled and capture output for comparisons."""
+        with utils.Scanner(patterns, **kwargs) as scanner:
+            scanner.scan(file, _context_callback)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _context_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_invert"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_invert(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner inverted match reporting."""
+
+    def _invert_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan with inverted matching enabled and capture output for comparisons."""
+        with utils.Scanner(patterns, **kwargs) as scanner:
+            scanner.scan(file, _basic_callback)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _invert_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_line_dedup"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_line_dedup(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner per line deduped match reporting."""
+
+    def _line_dedup_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan with line dedup enabled and capture output for comparisons."""
+        with utils.Scanner(patterns, **kwargs) as scanner:
+            scanner.scan(file, _line_dedup_callback)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _line_dedup_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_byte_offset"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_byte_offset(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner absolute byte offset reporting."""
+
+    def _byte_offset_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan and capture per line byte offsets for comparisons."""
+        with utils.Scanner(patterns, **kwargs) as scanner:
+            scanner.scan(file, _byte_offset_callback)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _byte_offset_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_stdin"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_stdin(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner standard input streaming through the grep style "-" marker."""
+
+    def _stdin_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan a file redirected onto stdin and capture output for comparisons."""
+        with utils.Scanner(patterns, **kwargs) as scanner, open(file, "rb") as source:
+            original = os.dup(0)
+            try:
+                os.dup2(source.fileno(), 0)
+                scanner.scan("-", _basic_callback)
+            finally:
+                os.dup2(original, 0)
+                os.close(original)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _stdin_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_fifo"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_fifo(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner streaming named pipes instead of mapping them like regular files."""
+
+    def _fifo_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan a FIFO fed by a writer thread and capture output for comparisons."""
+        fifo_path = os.path.join(tempfile.gettempdir(), f"hypergrep_test_fifo_{os.getpid()}")
+        if os.path.exists(fifo_path):
+            os.remove(fifo_path)
+        os.mkfifo(fifo_path)
+
+        def _feed_fifo() -> None:
+            """Replay the source file into the FIFO, blocking until the scanner opens the read side."""
+            with open(file, "rb") as source, open(fifo_path, "wb") as sink:
+                sink.write(source.read())
+
+        writer = threading.Thread(target=_feed_fifo)
+        writer.start()
+        try:
+            with utils.Scanner(patterns, **kwargs) as scanner:
+                scanner.scan(fifo_path, _basic_callback)
+        finally:
+            writer.join()
+            os.remove(fifo_path)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _fifo_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_parallel"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_parallel(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner multi threaded scans matching the serial output and ordering."""
+
+    def _parallel_helper(patterns: list, kind: str, **kwargs: Any) -> list:
+        """Helper to scan a generated oversized fixture with threads and capture output for comparisons."""
+        scan_kwargs = {key: kwargs.pop(key) for key in ("threads", "max_match_count") if key in kwargs}
+        callback = _basic_callback
+        if kwargs.get("line_dedup"):
+            callback = _line_dedup_callback
+        elif kwargs.get("before_context") or kwargs.get("after_context"):
+            callback = _context_callback
+        with utils.Scanner(patterns, **kwargs) as scanner:
+            scanner.scan(_parallel_fixture(kind), callback, **scan_kwargs)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _parallel_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_shared"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_shared(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner shared memory result transport."""
+
+    def _shared_helper(patterns: list, file: str, **kwargs: Any) -> list:
+        """Helper to scan through the shared transport and capture output for comparisons."""
+        with utils.Scanner(patterns) as scanner:
+            scanner.scan_shared(file, _shared_callback, **kwargs)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _shared_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scanner_tree"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scanner_tree(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for Scanner native directory tree scans."""
+
+    def _tree_helper(patterns: list, root: str, **kwargs: Any) -> list:
+        """Helper to scan a directory tree and capture output for comparisons."""
+        names = {}
+
+        def _on_file(file_index: int, file_name: bytes) -> None:
+            """Record announced files so results can be mapped back to paths."""
+            names[file_index] = os.path.basename(file_name.decode())
+
+        def _tree_callback(matches: list, count: int) -> None:
+            """Callback for C library to send results tagged with tree file indexes."""
+            for index in range(count):
+                match = matches[index]
+                line = match.line.decode(errors="ignore")
+                print(f"{names[match.file_index]}:{match.line_number}:{line.rstrip()}")
+
+        with utils.Scanner(patterns) as scanner:
+            scanner.scan_tree(root, _tree_callback, on_file=_on_file, **kwargs)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _tree_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scan_files"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scan_files(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for scan_files batch function."""
+
+    def _scan_files_helper(*args: Any, **kwargs: Any) -> list:
+        """Helper to run scan_files and capture output for comparisons."""
+        utils.scan_files(*args, **kwargs)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _scan_files_helper)
+
+
+@pytest.mark.parametrize_test_case("test_case", TEST_CASES["scan_range"])
+@pytest.mark.skipif(
+    sys.platform != "linux",
+    reason="Hyperscan libraries only support Linux",
+)
+def test_scan_range(test_case: dict, capsys: Any, function_tester: Callable) -> None:
+    """Tests for scan_range sharded scans."""
+
+    def _scan_range_helper(*args: Any, **kwargs: Any) -> list:
+        """Helper to run scan_range and capture output for comparisons."""
+        utils.scan_range(*args, **kwargs)
+        capture = capsys.readouterr()
+        stdout = capture.out.splitlines()
+        return stdout
+
+    function_tester(test_case, _scan_range_helper)
+
+
 @pytest.mark.parametrize_test_case("test_case", TEST_CASES["parallel_grep"])
 @pytest.mark.skipif(
     sys.platform != "linux",
@@ -1,9 +1,11 @@
 """Utilities for scanning text files with Intel Hyperscan."""
 
 import ctypes
+import hashlib
 import os
 import re
 import threading
+from typing import Any
 from typing import Callable
 
 # Flags pulled from hs_compile.h
@@ -11,10 +13,19 @@ HS_FLAG_CASELESS = 1
 HS_FLAG_DOTALL = 2
 HS_FLAG_MULTILINE = 4
 HS_FLAG_SINGLEMATCH = 8
+HS_FLAG_SOM_LEFTMOST = 256
 
 # Use 101-125 as utility return codes to avoid conflicts with hyperscan and linux return codes.
 RC_INVALID_FILE = 101
 
+# Native return code from the C backend when binary skipping is enabled and a file looks binary.
+RC_BINARY_FILE = 11
+
+# Result classifications from the C backend, so callbacks can tell context lines from matches.
+RESULT_MATCH = 0
+RESULT_CONTEXT_BEFORE = 1
+RESULT_CONTEXT_AFTER = 2
+
 __libhs__ = None
 __libhs_path__ = ""
 __libhyperscanner__ = None
@@ -30,13 +41,32 @@ class Result(ctypes.Structure):
     Fields:
         id: The index of the pattern that matched the line.
         line_number: The index of the line matched in the file.
-        line: Contents of the line that was matched.
+        line: Contents of the line that was matched. Shared memory slice, only valid during the callback.
+        length: Length of the line in bytes, excluding the C string terminator.
+        match_start: Offset within the line where the match began.
+            Only populated when the pattern was compiled with HS_FLAG_SOM_LEFTMOST, 0 otherwise.
+        match_end: Offset within the line one past the final byte of the match.
+        file_index: Position of the file that produced the match within the scanned file list.
+            Always 0 for single file scans.
+        context: Classification of the result: RESULT_MATCH for matched lines, or
+            RESULT_CONTEXT_BEFORE/RESULT_CONTEXT_AFTER when the line is reported only as context.
+        id_mask: Bitmask of the pattern ids below 64 that matched the line. A single bit for normal
+            scans; with line_dedup enabled every pattern that hit the line folds its bit in.
+        byte_offset: Absolute byte offset where the line begins, i.e. grep -b. Offsets are within
+            the decoded stream for compressed files, so a reported record can be seeked back to later.
     """
 
     _fields_ = [
         ("id", ctypes.c_uint),
         ("line_number", ctypes.c_ulonglong),
         ("line", ctypes.c_char_p),
+        ("length", ctypes.c_uint),
+        ("match_start", ctypes.c_ulonglong),
+        ("match_end", ctypes.c_ulonglong),
+        ("file_index", ctypes.c_uint),
+        ("context", ctypes.c_uint),
+        ("id_mask", ctypes.c_ulonglong),
+        ("byte_offset", ctypes.c_ulonglong),
     ]
 
 
@@ -51,6 +81,563 @@ CALLBACK_TYPE = ctypes.CFUNCTYPE(
 )
 
 
+class Counters(ctypes.Structure):
+    """Opt-in distribution counters collected across a single file scan.
+
+    C implementation located in hypergrep/lib/c/hyperscanner.c.
+
+    All zero unless the scanner was created with counters enabled and the scan requested stats.
+    Totals answer how long a scan took, distributions answer how to size it: line length spread
+    picks buffer_size, batch fill levels pick buffer_count, and per id tallies expose which
+    patterns carry the load.
+
+    Fields:
+        line_lengths: Histogram of scanned line lengths, including the trailing newline, in power
+            of two buckets. Bucket N covers lines of 2**N to 2**(N+1) - 1 bytes, and the last
+            bucket absorbs everything longer.
+        matches_per_id: Matches recorded per pattern id, before any single match per line
+            deduplication. Ids beyond the array are not tallied.
+        batch_fill: Histogram of how full the result buffer was at each flush, in even fractions
+            of its capacity. A top heavy histogram means buffer_count is the batching bottleneck.
+        buffer_refills: How many block reads the pipeline reader performed.
+            0 for plain text files, which are memory mapped instead of read through buffers.
+    """
+
+    _fields_ = [
+        ("line_lengths", ctypes.c_ulonglong * 16),
+        ("matches_per_id", ctypes.c_ulonglong * 64),
+        ("batch_fill", ctypes.c_ulonglong * 8),
+        ("buffer_refills", ctypes.c_ulonglong),
+    ]
+
+
+class Stats(ctypes.Structure):
+    """Performance counters collected across a single file scan.
+
+    C implementation located in hypergrep/lib/c/hyperscanner.c.
+
+    Fields:
+        bytes_read: Raw bytes read from storage, i.e. compressed size for GZIP/ZSTD and file size for plain text.
+        bytes_scanned: Decoded bytes fed through the Hyperscan engine.
+        lines_scanned: Complete lines fed through the Hyperscan engine.
+        matches: Matches recorded, after any single match per line deduplication.
+        read_ns: Nanoseconds spent reading and decompressing input.
+            0 for plain text files, where page faults are absorbed into scan time.
+        scan_ns: Nanoseconds spent inside the Hyperscan engine, excluding time spent in the callback.
+        callback_ns: Nanoseconds spent inside the caller's result callback.
+        counters: Opt-in distribution counters, all zero unless the scanner enabled them.
+    """
+
+    _fields_ = [
+        ("bytes_read", ctypes.c_ulonglong),
+        ("bytes_scanned", ctypes.c_ulonglong),
+        ("lines_scanned", ctypes.c_ulonglong),
+        ("matches", ctypes.c_ulonglong),
+        ("read_ns", ctypes.c_ulonglong),
+        ("scan_ns", ctypes.c_ulonglong),
+        ("callback_ns", ctypes.c_ulonglong),
+        ("counters", Counters),
+    ]
+
+
+class SharedResult(ctypes.Structure):
+    """Result record written by the C backend into caller provided shared memory.
+
+    C implementation located in hypergrep/lib/c/hyperscanner.c.
+
+    Identical to Result except the line is referenced by its offset within the shared arena
+    instead of a pointer, so callers can slice one memoryview lazily instead of paying for
+    a bytes object per line in every batch.
+
+    Fields:
+        line_offset: Offset of the line within the shared arena.
+            Remaining fields match Result.
+    """
+
+    _fields_ = [
+        ("id", ctypes.c_uint),
+        ("line_number", ctypes.c_ulonglong),
+        ("line_offset", ctypes.c_ulonglong),
+        ("length", ctypes.c_uint),
+        ("match_start", ctypes.c_ulonglong),
+        ("match_end", ctypes.c_ulonglong),
+        ("file_index", ctypes.c_uint),
+        ("context", ctypes.c_uint),
+        ("id_mask", ctypes.c_ulonglong),
+        ("byte_offset", ctypes.c_ulonglong),
+    ]
+
+
+# C function type used by hyperscanner to signal shared memory batches with only the filled count.
+SHARED_CALLBACK_TYPE = ctypes.CFUNCTYPE(
+    None,
+    ctypes.c_int,
+    use_errno=False,
+    use_last_error=False,
+)
+
+
+# C function type used by hyperscanner to announce each discovered file on the tree scan path.
+PATH_CALLBACK_TYPE = ctypes.CFUNCTYPE(
+    None,
+    ctypes.c_uint,
+    ctypes.c_char_p,
+    use_errno=False,
+    use_last_error=False,
+)
+
+
+class Scanner:
+    """Persistent Intel Hyperscan scanner that compiles the pattern database once and reuses it across files.
+
+    C implementation located in hypergrep/lib/c/hyperscanner.c.
+
+    Use instead of repeated "scan()" calls when the same patterns are applied to many files,
+    to pay the database compilation and scratch allocation costs only once per job.
+    Instances are not safe to share across simultaneous scans; create one per thread.
+
+    Pattern sets made entirely of fixed strings (host names, request IDs, etc.) are detected
+    natively and compiled through Hyperscan's literal matcher for faster startup and scanning.
+    """
+
+    def __init__(
+        self,
+        patterns: list[str],
+        flags: list[int] = (),
+        ids: list[int] = (),
+        database_cache_dir: str | None = None,
+        skip_binary: bool = False,
+        before_context: int = 0,
+        after_context: int = 0,
+        invert: bool = False,
+        line_dedup: bool = False,
+        scratch_pool_size: int | None = None,
+        counters: bool = False,
+    ) -> None:
+        """Compile the patterns into a reusable Hyperscan database and scratch space.
+
+        Args:
+            patterns: Regex patterns in text format used to match lines.
+            flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+                Flags must use bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH = 10
+                Defaults to: HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
+            ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+                Defaults to: All patterns share the same ID; multiple callbacks for the same line are not received.
+            database_cache_dir: Optional directory used to cache the serialized database between processes.
+                The first scanner compiles and saves the database, later scanners deserialize in microseconds.
+                Cache files are keyed on the patterns, flags, ids, and Hyperscan version.
+            skip_binary: Whether to probe the first bytes of each file for NUL and skip binary files,
+                e.g. core dumps or databases in log directories. Skipped scans return RC_BINARY_FILE
+                instead of streaming unscannable data through the engine.
+            before_context: How many lines before each match to report as context results, i.e. grep -B.
+                Context lines arrive in file order through the normal callback batches with the
+                result "context" field set; no line is ever reported twice.
+            after_context: How many lines after each match to report as context results, i.e. grep -A.
+            invert: Whether to report the lines no pattern matched instead of the lines that matched,
+                i.e. grep -v, evaluated natively without streaming every line back for filtering.
+                Inverted results use pattern id 0 with zeroed match offsets, and counts tally under id 0.
+            line_dedup: Whether to report at most one result per line when overlapping patterns hit,
+                cutting callback volume on broad triage sets. The result "id" carries the first
+                pattern that hit and "id_mask" accumulates a bit for every hitting id below 64.
+            scratch_pool_size: How many cloned scratch spaces to retain between scans for parallel
+                workers, skipping a per scan allocation that is megabytes for large databases.
+                Defaults to the native library's bound; pass 0 to disable pooling.
+            counters: Whether scans that request stats also fill the distribution counters block,
+                i.e. line length, per pattern id, batch fill, and buffer refill distributions.
+                Used to size buffer_size and buffer_count for a new source without trial and error.
+
+        Raises:
+            ValueError if the patterns could not be compiled by Intel Hyperscan.
+        """
+        pattern_array, flags_array, ids_array = prepare_patterns(patterns, flags=flags, ids=ids)
+        # Track the id range so count() can size per-id tallies without the caller resending ids.
+        self._count_elements = max(ids_array) + 1
+        cache_path = None
+        if database_cache_dir:
+            os.makedirs(database_cache_dir, exist_ok=True)
+            cache_path = _database_cache_path(database_cache_dir, pattern_array, flags_array, ids_array).encode()
+        hyperscanner_lib = _get_hyperscanner_lib()
+        self._handle = ctypes.c_void_p()
+        ret_code = hyperscanner_lib.hyperscanner_create(
+            ctypes.byref(self._handle),
+            pattern_array,
+            flags_array,
+            ids_array,
+            len(pattern_array),
+            cache_path,
+        )
+        if ret_code:
+            raise ValueError(f"Unable to compile Hyperscan database, received return code {ret_code}")
+        if skip_binary:
+            hyperscanner_lib.hyperscanner_set_binary_skip(self._handle, 1)
+        if before_context or after_context:
+            hyperscanner_lib.hyperscanner_set_context(self._handle, before_context, after_context)
+        if invert:
+            hyperscanner_lib.hyperscanner_set_invert(self._handle, 1)
+        if line_dedup:
+            hyperscanner_lib.hyperscanner_set_line_dedup(self._handle, 1)
+        if scratch_pool_size is not None:
+            hyperscanner_lib.hyperscanner_set_scratch_pool(self._handle, scratch_pool_size)
+        if counters:
+            hyperscanner_lib.hyperscanner_set_counters(self._handle, 1)
+
+    def __enter__(self) -> "Scanner":
+        """Allow use as a context manager to guarantee release of the native resources."""
+        return self
+
+    def __exit__(self, *args: Any) -> None:
+        """Release the native resources when leaving a context manager block."""
+        self.close()
+
+    def close(self) -> None:
+        """Release the compiled database and scratch space. The scanner cannot be used afterwards."""
+        if self._handle:
+            hyperscanner_lib = _get_hyperscanner_lib()
+            hyperscanner_lib.hyperscanner_destroy(self._handle)
+            self._handle = None
+
+    def count(
+        self,
+        path: str,
+        buffer_size: int = 262140,
+        max_match_count: int = 0,
+    ) -> tuple[list[int], int]:
+        """Count matches in a text file per pattern id without materializing any lines.
+
+        Memory flat fast path for "grep -c" style workloads: no result buffers, no line copies,
+        and no Python callback crossings. With HS_FLAG_SINGLEMATCH patterns the counts are matching lines.
+
+        Args:
+            path: Location of the file to be read by hyperscan.
+            buffer_size: How large of a buffer to use while reading compressed files line by line.
+            max_match_count: Stop reading the file after requested number of matches found.
+                Use 0 to indicate no limit.
+
+        Returns:
+            Match count per pattern id, and response code received from the C backend if there was a failure.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        counts_array = (ctypes.c_ulonglong * self._count_elements)()
+        hyperscanner_lib = _get_hyperscanner_lib()
+        ret_code = _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_count_file(
+                self._handle,
+                path.encode(),
+                counts_array,
+                self._count_elements,
+                buffer_size,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+        return list(counts_array), ret_code
+
+    def scan(  # pylint: disable=too-many-arguments
+        self,
+        path: str,
+        callback: Callable,
+        buffer_size: int = 262140,
+        buffer_count: int = 16,
+        max_match_count: int = 0,
+        threads: int = 1,
+        stats: Stats | None = None,
+    ) -> int:
+        """Read a text file for the compiled regex patterns using Intel Hyperscan.
+
+        Supports GZIP, ZSTD, and Plain Text files.
+
+        Args:
+            path: Location of the file to be read by hyperscan. Pass "-" to stream standard input
+                instead, decoding compressed bytes transparently without any temp files or seeking.
+            callback: Where every regex hit (line index, pattern id, and byte string) are sent.
+                Must match CALLBACK_TYPE.
+            buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+            buffer_count: How many line matches to buffer before calling callback.
+            max_match_count: Stop reading the file after requested number of matches found.
+                Use 0 to indicate no limit.
+            threads: How many native threads to scan the file with. Greater than 1 splits uncompressed
+                files into newline aligned segments scanned in parallel, with results merged in file order.
+                Multi-member gzip archives, such as rotated logs, decompress their members in parallel.
+                Other compressed files always scan single threaded.
+            stats: Optional counters reset and filled during the scan for performance analysis.
+                Only collected on single threaded scans; ignored when threads is greater than 1.
+
+        Returns:
+            Response code received from the C backend if there was a failure, 0 otherwise.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        # Wrap the callback in the ctype to allow passing to C functions.
+        c_callback = CALLBACK_TYPE(callback)
+        hyperscanner_lib = _get_hyperscanner_lib()
+        if threads > 1:
+            return _run_scan(
+                lambda: hyperscanner_lib.hyperscanner_scan_file_parallel(
+                    self._handle,
+                    path.encode(),
+                    c_callback,
+                    buffer_size,
+                    buffer_count,
+                    ctypes.c_ulonglong(max_match_count),
+                    threads,
+                )
+            )
+        if stats is not None:
+            return _run_scan(
+                lambda: hyperscanner_lib.hyperscanner_scan_file_stats(
+                    self._handle,
+                    path.encode(),
+                    c_callback,
+                    buffer_size,
+                    buffer_count,
+                    ctypes.c_ulonglong(max_match_count),
+                    ctypes.byref(stats),
+                )
+            )
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_scan_file(
+                self._handle,
+                path.encode(),
+                c_callback,
+                buffer_size,
+                buffer_count,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+
+    def scan_files(  # pylint: disable=too-many-arguments
+        self,
+        paths: list[str],
+        callback: Callable,
+        buffer_size: int = 262140,
+        buffer_count: int = 16,
+        max_match_count: int = 0,
+    ) -> int:
+        """Read a list of text files with one native call, reusing every buffer across the whole batch.
+
+        Results are tagged with the index of the file that produced them via "Result.file_index",
+        so one callback stream serves the entire batch. Scanning continues past per file failures.
+
+        Args:
+            paths: Locations of the files to be read by hyperscan.
+            callback: Where every regex hit (file index, line index, pattern id, and byte string) are sent.
+                Must match CALLBACK_TYPE.
+            buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+            buffer_count: How many line matches to buffer before calling callback.
+            max_match_count: Stop reading each file after requested number of matches found.
+                Use 0 to indicate no limit.
+
+        Returns:
+            First non-zero response code received from the C backend if any file failed, 0 otherwise.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        encoded_paths = [path.encode() for path in paths]
+        path_array = (ctypes.c_char_p * len(encoded_paths))()
+        path_array[:] = encoded_paths
+        c_callback = CALLBACK_TYPE(callback)
+        hyperscanner_lib = _get_hyperscanner_lib()
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_scan_files(
+                self._handle,
+                path_array,
+                len(path_array),
+                c_callback,
+                buffer_size,
+                buffer_count,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+
+    def scan_range(  # pylint: disable=too-many-arguments
+        self,
+        path: str,
+        start_offset: int,
+        end_offset: int,
+        callback: Callable,
+        line_number_hint: int = 0,
+        buffer_size: int = 262140,
+        buffer_count: int = 16,
+        max_match_count: int = 0,
+    ) -> int:
+        """Read one byte range of an uncompressed text file, so huge files can be sharded across workers.
+
+        The range covers every line that begins in [start_offset, end_offset): the start skips any
+        partial line owned by the previous range, and the end extends through the final owned line's
+        newline. Adjacent ranges partition a file exactly with no duplicated or dropped lines.
+        Compressed files cannot be ranged and fail with the invalid file return code.
+
+        Args:
+            path: Location of the uncompressed file to be read by hyperscan.
+            start_offset: First byte of the range. Lines beginning before this offset belong to the previous range.
+            end_offset: One past the last byte of the range. Clamped to the file size.
+            callback: Where every regex hit (line index, pattern id, and byte string) are sent.
+                Must match CALLBACK_TYPE.
+            line_number_hint: How many lines precede start_offset, so results report absolute line numbers.
+                Use 0 if relative line numbers within the range are acceptable.
+            buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+            buffer_count: How many line matches to buffer before calling callback.
+            max_match_count: Stop reading the range after requested number of matches found.
+                Use 0 to indicate no limit.
+
+        Returns:
+            Response code received from the C backend if there was a failure, 0 otherwise.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        c_callback = CALLBACK_TYPE(callback)
+        hyperscanner_lib = _get_hyperscanner_lib()
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_scan_range(
+                self._handle,
+                path.encode(),
+                ctypes.c_ulonglong(start_offset),
+                ctypes.c_ulonglong(end_offset),
+                ctypes.c_ulonglong(line_number_hint),
+                c_callback,
+                buffer_size,
+                buffer_count,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+
+    def scan_shared(  # pylint: disable=too-many-arguments
+        self,
+        path: str,
+        callback: Callable,
+        arena_size: int = 524280,
+        slot_count: int = 256,
+        buffer_size: int = 262140,
+        max_match_count: int = 0,
+    ) -> int:
+        """Read a text file delivering results through shared memory instead of per batch string copies.
+
+        The C backend writes result lines into one shared arena and batch metadata into a shared
+        slot table as arena offsets, signalling the callback with only the count. The callback
+        slices the arena memoryview lazily, so match dense scans avoid allocating an intermediate
+        bytes object per line while the GIL is held.
+
+        Args:
+            path: Location of the file to be read by hyperscan.
+            callback: Called with (arena, slots, count) per batch: a memoryview over the shared
+                line arena, the SharedResult slot table, and how many slots were filled.
+                Slice the arena with slots[i].line_offset and slots[i].length; the contents are
+                only valid for the duration of the callback.
+            arena_size: Total capacity of the shared line arena in bytes.
+                Must hold the longest expected line plus one.
+            slot_count: How many results to buffer in the slot table before signalling the callback.
+            buffer_size: How large of a buffer to use while reading compressed files line by line.
+            max_match_count: Stop reading the file after requested number of matches found.
+                Use 0 to indicate no limit.
+
+        Returns:
+            Response code received from the C backend if there was a failure, 0 otherwise.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        arena = ctypes.create_string_buffer(arena_size)
+        arena_view = memoryview(arena)
+        slots = (SharedResult * slot_count)()
+
+        def _on_batch(count: int) -> None:
+            """Fan the shared buffers out to the caller with the filled slot count."""
+            callback(arena_view, slots, count)
+
+        c_callback = SHARED_CALLBACK_TYPE(_on_batch)
+        hyperscanner_lib = _get_hyperscanner_lib()
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_scan_file_shared(
+                self._handle,
+                path.encode(),
+                c_callback,
+                arena,
+                ctypes.c_ulonglong(arena_size),
+                slots,
+                slot_count,
+                buffer_size,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+
+    def scan_tree(  # pylint: disable=too-many-arguments
+        self,
+        root: str,
+        callback: Callable,
+        on_file: Callable | None = None,
+        buffer_size: int = 262140,
+        buffer_count: int = 16,
+        max_match_count: int = 0,
+    ) -> int:
+        """Recursively scan every regular file under a directory with one native call.
+
+        The C backend walks the tree natively, hints upcoming files to the kernel for readahead,
+        and streams every file through the shared database and buffers, so small file workloads
+        are bounded by I/O instead of per file dispatch. Files are visited in alphabetical order
+        per directory, symbolic links are skipped, and scanning continues past per file failures.
+
+        Args:
+            root: Directory to walk recursively for files to be read by hyperscan.
+            callback: Where every regex hit (file index, line index, pattern id, and byte string) are sent.
+                Must match CALLBACK_TYPE.
+            on_file: Called with (file_index, path bytes) as each file is announced, before its
+                results are emitted. Use to map "Result.file_index" back to paths.
+            buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+            buffer_count: How many line matches to buffer before calling callback.
+            max_match_count: Stop reading each file after requested number of matches found.
+                Use 0 to indicate no limit.
+
+        Returns:
+            First non-zero response code received from the C backend if any file failed, 0 otherwise.
+        """
+        if not self._handle:
+            raise ValueError("Scanner has been closed, create a new scanner to scan additional files")
+        c_callback = CALLBACK_TYPE(callback)
+        c_on_file = PATH_CALLBACK_TYPE(on_file) if on_file else PATH_CALLBACK_TYPE()
+        hyperscanner_lib = _get_hyperscanner_lib()
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscanner_scan_tree(
+                self._handle,
+                root.encode(),
+                c_on_file,
+                c_callback,
+                buffer_size,
+                buffer_count,
+                ctypes.c_ulonglong(max_match_count),
+            )
+        )
+
+
+def _database_cache_path(
+    cache_dir: str,
+    pattern_array: ctypes.Array,
+    flags_array: ctypes.Array,
+    ids_array: ctypes.Array,
+) -> str:
+    """Build a serialized database cache path unique to the full compilation request.
+
+    Serialized Hyperscan databases carry no record of the patterns or flags they were compiled from,
+    so the file name must be keyed on every input, plus the Hyperscan version, to stay safe to reuse.
+
+    Args:
+        cache_dir: Directory where serialized databases are stored.
+        pattern_array: C array of patterns from prepare_patterns.
+        flags_array: C array of flags from prepare_patterns.
+        ids_array: C array of ids from prepare_patterns.
+
+    Returns:
+        Path to a cache file that is only valid for this exact database.
+    """
+    digest = hashlib.sha256()
+    # Keyed on a serialization version as well, so caches compiled before a change to the native
+    # flag translation (e.g. the DOTALL strip that keeps matches within a single line) are not reused.
+    digest.update(b"hypergrep-db-v2\n")
+    digest.update(hyperscan_version().encode())
+    for pattern, flag, id_num in zip(pattern_array, flags_array, ids_array):
+        digest.update(pattern)
+        digest.update(f":{flag}:{id_num}\n".encode())
+    return os.path.join(cache_dir, f"hypergrep_{digest.hexdigest()}.hsdb")
+
+
 def _get_hyperscan_lib() -> ctypes.cdll:
     """Lazily load the Intel Hyperscan library to allow use in subprocesses.
 
@@ -94,6 +681,33 @@ def _get_zstd_lib() -> ctypes.cdll:
     return __libzstd__
 
 
+def _run_scan(scan_call: Callable) -> int:
+    """Run a blocking CDLL scan call on a background thread so that Python can intercept signals.
+
+    Args:
+        scan_call: Fully prepared callable that invokes the C library and returns its response code.
+
+    Returns:
+        Response code received from the C backend if there was a failure, 0 otherwise.
+    """
+    ret_code = 0
+
+    # NOTE: Do not remove this wrapper or change thread from daemon to ensure that Python receives signals.
+    def _wrapper() -> None:
+        """Wrapper to allow running the CDLL call as non-blocking and allow Python to intercept signals."""
+        nonlocal ret_code
+        ret_code = scan_call()
+
+    hyperscan_thread = threading.Thread(target=_wrapper, daemon=True)
+    hyperscan_thread.start()
+    try:
+        # Hard cap the thread at 1 hour in case anything goes wrong.
+        hyperscan_thread.join(timeout=3600)
+    except KeyboardInterrupt:
+        ret_code = 130
+    return ret_code
+
+
 def check_compatibility(
     patterns: list,
     flags: list[int] = (),
@@ -144,6 +758,53 @@ def configure_libraries(
         __libzstd_path__ = libzstd
 
 
+def count(  # pylint: disable=too-many-arguments
+    path: str,
+    patterns: list[str],
+    flags: list[int] = (),
+    ids: list[int] = (),
+    buffer_size: int = 262140,
+    max_match_count: int = 0,
+) -> tuple[list[int], int]:
+    """Count matches in a text file per pattern id using Intel Hyperscan without materializing any lines.
+
+    Supports GZIP, ZSTD, and Plain Text files. See Scanner.count() for reusing compiled patterns across files.
+
+    Args:
+        path: Location of the file to be read by hyperscan.
+        patterns: Regex patterns in text format used to match lines.
+        flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+            Flags must use bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH = 10
+            Defaults to: HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
+        ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+            Defaults to: All patterns share the same ID; one count is returned for the whole group.
+        buffer_size: How large of a buffer to use while reading compressed files line by line.
+        max_match_count: Stop reading the file after requested number of matches found.
+            Use 0 to indicate no limit.
+
+    Returns:
+        Match count per pattern id, and response code received from the C backend if there was a failure.
+    """
+    pattern_array, flags_array, ids_array = prepare_patterns(patterns, flags=flags, ids=ids)
+    count_elements = max(ids_array) + 1
+    counts_array = (ctypes.c_ulonglong * count_elements)()
+    hyperscanner_lib = _get_hyperscanner_lib()
+    ret_code = _run_scan(
+        lambda: hyperscanner_lib.hyperscan_count(
+            path.encode(),
+            pattern_array,
+            flags_array,
+            ids_array,
+            len(pattern_array),
+            counts_array,
+            count_elements,
+            buffer_size,
+            ctypes.c_ulonglong(max_match_count),
+        )
+    )
+    return list(counts_array), ret_code
+
+
 def grep(  # pylint: disable=too-many-arguments
     file: str,
     patterns: list[str],
@@ -160,7 +821,7 @@ def grep(  # pylint: disable=too-many-arguments
     basic functionality on a system, or simple use cases.
 
     Args:
-        file: Path to a file on the local filesystem.
+        file: Path to a file on the local filesystem, or "-" to stream standard input.
         patterns: Regex patterns compatible with Intel Hyperscan.
         ignore_case: Perform case-insensitive matching.
         count_only: Whether to count the matches, instead of decode the byte lines and store them.
@@ -195,42 +856,61 @@ def grep(  # pylint: disable=too-many-arguments
             raise ValueError("is a directory")
 
     if not return_code:
+        # Always use hyperscan function defaults, but add caseless if user requested.
+        flags = HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
+        if ignore_case:
+            flags |= HS_FLAG_CASELESS
 
-        def _c_callback(matches: list, count: int) -> None:
-            """Called by the C library everytime it finds a batch of matching lines."""
-            nonlocal results
-            if count_only:
-                results += count
-            else:
+        if count_only:
+            # Counting runs entirely in C without materializing lines or crossing back into Python per match.
+            counts, return_code = count(
+                file,
+                patterns,
+                flags=[flags for _ in patterns],
+                max_match_count=max_match_count,
+            )
+            results = sum(counts)
+        else:
+
+            def _c_callback(matches: list, match_count: int) -> None:
+                """Called by the C library everytime it finds a batch of matching lines."""
+                nonlocal results
                 if only_matching:
                     # "Only matching" grep behavior converts every line into every match group per line.
-                    for index in range(count):
+                    for index in range(match_count):
                         match = matches[index]
                         line = match.line.decode(errors=errors)
                         # NOTE: Do not use findall, only finditer provides the correct results.
                         for partial in compiled_patterns[match.id].finditer(line):
                             results.append((match.line_number + 1, f"{partial.group()}\n"))
                 else:
-                    for index in range(count):
+                    for index in range(match_count):
                         match = matches[index]
                         line = match.line.decode(errors=errors)
                         results.append((match.line_number + 1, line))
 
-        # Always use hyperscan function defaults, but add caseless if user requested.
-        flags = HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
-        if ignore_case:
-            flags |= HS_FLAG_CASELESS
-        return_code = scan(
-            file,
-            patterns,
-            _c_callback,
-            flags=[flags for _ in patterns],
-            max_match_count=max_match_count,
-        )
+            return_code = scan(
+                file,
+                patterns,
+                _c_callback,
+                flags=[flags for _ in patterns],
+                max_match_count=max_match_count,
+            )
 
     return results, return_code
 
 
+def hyperscan_version() -> str:
+    """Read the version of the Intel Hyperscan library currently in use.
+
+    Returns:
+        Version string reported by Hyperscan. e.g. "5.4.2 2023-04-22"
+    """
+    hyperscan_lib = _get_hyperscan_lib()
+    hyperscan_lib.hs_version.restype = ctypes.c_char_p
+    return hyperscan_lib.hs_version().decode()
+
+
 def prepare_patterns(
     patterns: list[str],
     flags: list[int] = (),
@@ -252,7 +932,8 @@ def prepare_patterns(
     if not flags:
         # Set the default flags for most common usage if none were provided.
         # Hyperscan flags: https://intel.github.io/hyperscan/dev-reference/api_files.html
-        # HS_FLAG_DOTALL for performance.
+        # HS_FLAG_DOTALL for performance. The native layer strips it at compile so dot never
+        # crosses a newline; matches are always contained within a single line.
         # HS_FLAG_MULTILINE to match ^ and $ against newlines.
         # HS_FLAG_SINGLEMATCH to stop after first callback for a pattern.
         flags = [HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH for _ in patterns]
@@ -298,13 +979,14 @@ def scan(  # pylint: disable=too-many-arguments
     buffer_size: int = 262140,
     buffer_count: int = 16,
     max_match_count: int = 0,
+    stats: Stats | None = None,
 ) -> int:
     """Read a text file for regex patterns using Intel Hyperscan.
 
     Supports GZIP, ZSTD, and Plain Text files.
 
     Args:
-        path: Location of the file to be read by hyperscan.
+        path: Location of the file to be read by hyperscan. Pass "-" to stream standard input.
         patterns: Regex patterns in text format used to match lines.
         callback: Where every regex hit (line index, pattern id, and byte string) are sent.
             Must match CALLBACK_TYPE.
@@ -321,6 +1003,8 @@ def scan(  # pylint: disable=too-many-arguments
                 Multiprocessing or few matches = decrease limit or leave as is.
         max_match_count: Stop reading the file after requested number of matches found.
             Use 0 to indicate no limit.
+        stats: Optional counters reset and filled during the scan for performance analysis.
+            Database compilation time is not included in the counters.
 
     Returns:
         Response code received from the C backend if there was a failure, 0 otherwise.
@@ -330,13 +1014,23 @@ def scan(  # pylint: disable=too-many-arguments
     # Wrap the callback in the ctype to allow passing to C functions.
     callback = CALLBACK_TYPE(callback)
     hyperscanner_lib = _get_hyperscanner_lib()
-    ret_code = 0
-
-    # NOTE: Do not remove this wrapper or change thread from daemon to ensure that Python receives signals.
-    def _wrapper() -> None:
-        """Wrapper to allow running the CDLL call as non-blocking and allow Python to intercept signals."""
-        nonlocal ret_code
-        ret_code = hyperscanner_lib.hyperscan(
+    if stats is not None:
+        return _run_scan(
+            lambda: hyperscanner_lib.hyperscan_stats(
+                path.encode(),
+                pattern_array,
+                flags_array,
+                ids_array,
+                len(pattern_array),
+                callback,
+                buffer_size,
+                buffer_count,
+                ctypes.c_ulonglong(max_match_count),
+                ctypes.byref(stats),
+            )
+        )
+    return _run_scan(
+        lambda: hyperscanner_lib.hyperscan(
             path.encode(),
             pattern_array,
             flags_array,
@@ -347,15 +1041,129 @@ def scan(  # pylint: disable=too-many-arguments
             buffer_count,
             ctypes.c_ulonglong(max_match_count),
         )
+    )
 
-    hyperscan_thread = threading.Thread(target=_wrapper, daemon=True)
-    hyperscan_thread.start()
-    try:
-        # Hard cap the thread at 1 hour in case anything goes wrong.
-        hyperscan_thread.join(timeout=3600)
-    except KeyboardInterrupt:
-        ret_code = 130
-    return ret_code
+
+def scan_files(  # pylint: disable=too-many-arguments
+    paths: list[str],
+    patterns: list[str],
+    callback: Callable,
+    flags: list[int] = (),
+    ids: list[int] = (),
+    buffer_size: int = 262140,
+    buffer_count: int = 16,
+    max_match_count: int = 0,
+) -> int:
+    """Read a list of text files for regex patterns with one native call using Intel Hyperscan.
+
+    Supports GZIP, ZSTD, and Plain Text files. The database and all scan buffers are reused across
+    the whole batch, and results are tagged with the index of the file that produced them via
+    "Result.file_index". Scanning continues past per file failures.
+
+    Args:
+        paths: Locations of the files to be read by hyperscan.
+        patterns: Regex patterns in text format used to match lines.
+        callback: Where every regex hit (file index, line index, pattern id, and byte string) are sent.
+            Must match CALLBACK_TYPE.
+        flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+            Flags must use bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH = 10
+            Defaults to: HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
+        ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+            Defaults to: All patterns share the same ID; multiple callbacks for the same line are not received.
+        buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+        buffer_count: How many line matches to buffer before calling callback.
+        max_match_count: Stop reading each file after requested number of matches found.
+            Use 0 to indicate no limit.
+
+    Returns:
+        First non-zero response code received from the C backend if any file failed, 0 otherwise.
+    """
+    pattern_array, flags_array, ids_array = prepare_patterns(patterns, flags=flags, ids=ids)
+    encoded_paths = [path.encode() for path in paths]
+    path_array = (ctypes.c_char_p * len(encoded_paths))()
+    path_array[:] = encoded_paths
+
+    # Wrap the callback in the ctype to allow passing to C functions.
+    callback = CALLBACK_TYPE(callback)
+    hyperscanner_lib = _get_hyperscanner_lib()
+    return _run_scan(
+        lambda: hyperscanner_lib.hyperscan_files(
+            path_array,
+            len(path_array),
+            pattern_array,
+            flags_array,
+            ids_array,
+            len(pattern_array),
+            callback,
+            buffer_size,
+            buffer_count,
+            ctypes.c_ulonglong(max_match_count),
+        )
+    )
+
+
+def scan_range(  # pylint: disable=too-many-arguments
+    path: str,
+    start_offset: int,
+    end_offset: int,
+    patterns: list[str],
+    callback: Callable,
+    line_number_hint: int = 0,
+    flags: list[int] = (),
+    ids: list[int] = (),
+    buffer_size: int = 262140,
+    buffer_count: int = 16,
+    max_match_count: int = 0,
+) -> int:
+    """Read one byte range of an uncompressed text file for regex patterns using Intel Hyperscan.
+
+    The range covers every line that begins in [start_offset, end_offset): adjacent ranges partition
+    a file exactly with no duplicated or dropped lines, so one huge file can be sharded across worker
+    processes the same way file lists are sharded today. Compressed files cannot be ranged.
+
+    Args:
+        path: Location of the uncompressed file to be read by hyperscan.
+        start_offset: First byte of the range. Lines beginning before this offset belong to the previous range.
+        end_offset: One past the last byte of the range. Clamped to the file size.
+        patterns: Regex patterns in text format used to match lines.
+        callback: Where every regex hit (line index, pattern id, and byte string) are sent.
+            Must match CALLBACK_TYPE.
+        line_number_hint: How many lines precede start_offset, so results report absolute line numbers.
+            Use 0 if relative line numbers within the range are acceptable.
+        flags: Flags to set on each pattern in order to match. i.e. HS_FLAG_DOTALL
+            Flags must use bitwise OR operator to combine flags. e.g. HS_FLAG_DOTALL | HS_FLAG_SINGLEMATCH = 10
+            Defaults to: HS_FLAG_DOTALL | HS_FLAG_MULTILINE | HS_FLAG_SINGLEMATCH
+        ids: IDs to apply to each pattern to group related patterns and prevent separate callbacks.
+            Defaults to: All patterns share the same ID; multiple callbacks for the same line are not received.
+        buffer_size: How large of a buffer to use while reading in chars. Reads up to first newline or len - 1.
+        buffer_count: How many line matches to buffer before calling callback.
+        max_match_count: Stop reading the range after requested number of matches found.
+            Use 0 to indicate no limit.
+
+    Returns:
+        Response code received from the C backend if there was a failure, 0 otherwise.
+    """
+    pattern_array, flags_array, ids_array = prepare_patterns(patterns, flags=flags, ids=ids)
+
+    # Wrap the callback in the ctype to allow passing to C functions.
+    callback = CALLBACK_TYPE(callback)
+    hyperscanner_lib = _get_hyperscanner_lib()
+    return _run_scan(
+        lambda: hyperscanner_lib.hyperscan_range(
+            path.encode(),
+            ctypes.c_ulonglong(start_offset),
+            ctypes.c_ulonglong(end_offset),
+            ctypes.c_ulonglong(line_number_hint),
+            pattern_array,
+            flags_array,
+            ids_array,
+            len(pattern_array),
+            callback,
+            buffer_size,
+            buffer_count,
+            ctypes.c_ulonglong(max_match_count),
+        )
+    )
 
 
 # Call configuration update at least once to use defaults.
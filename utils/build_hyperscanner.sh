@@ -72,7 +72,8 @@ project_dir="$(cd "$(dirname "$0")" && git rev-parse --show-toplevel)"
 cd "${project_dir}"/hypergrep/lib/c
 # All warnings are failures to enforce clean code.
 # Must use "-std=c99" to be compatible down to U14.04 (Trusty).
-gcc -std=c99 -c -Wall -Werror -fpic hyperscanner.c \
+# Must use "-pthread" for the parallel file scanning worker threads.
+gcc -std=c99 -pthread -c -Wall -Werror -fpic hyperscanner.c \
   "${build_dir}"/zstd/zlibWrapper/gz*.c \
   "${build_dir}"/zstd/zlibWrapper/zstd_zlibwrapper.c \
   -I "${build_dir}"/zstd/lib \
@@ -80,7 +81,7 @@ gcc -std=c99 -c -Wall -Werror -fpic hyperscanner.c \
   -I "${build_dir}"/hyperscan/lib \
   -I "${build_dir}"/hyperscan/src \
   $(pkg-config --cflags --libs zlib)
-gcc -shared -o "${project_dir}"/hypergrep/lib/libhyperscanner.so \
+gcc -shared -pthread -o "${project_dir}"/hypergrep/lib/libhyperscanner.so \
   hyperscanner.o \
   gz*.o \
   zstd*.o \